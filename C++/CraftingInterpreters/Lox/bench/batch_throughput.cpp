@@ -0,0 +1,127 @@
+// Scripts per second for a directory of small scripts, run as one batch on
+// 1, 2, 4 ... threads up to the hardware's, against launching the
+// interpreter once per script the way a nightly job would without --batch.
+// usage: bench/batch_throughput [scripts] [interpreter]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lox/lox.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+namespace
+{
+    // a few shapes of small script, each prints a line so the batch's output has something in it
+    const char* const SCRIPTS[] = {
+        "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\nprint fib(15);\n",
+        "var total = 0;\nfor (var i = 0; i < 5000; i = i + 1) total = total + i;\nprint total;\n",
+        "class Point { init(x, y) { this.x = x; this.y = y; } sum() { return this.x + this.y; } }\n"
+        "var s = 0;\nfor (var i = 0; i < 1000; i = i + 1) s = s + Point(i, 1).sum();\nprint s;\n",
+        "var s = \"\";\nfor (var i = 0; i < 200; i = i + 1) s = s + \"ab\";\nprint s == s;\n",
+    };
+
+    double secondsSince(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    // the whole directory as one batch in this process, which exits with the
+    // failing script's status if one fails, the same as the interpreter does
+    double runBatch(const std::string& directory, unsigned int threads)
+    {
+        std::ostringstream output, errors;
+        Lox lox(output, errors);
+        std::vector<std::string> args = {"lox", "--batch", "--jobs", std::to_string(threads), directory};
+        std::vector<char*> argv;
+        for (std::string& arg : args) argv.push_back(arg.data());
+
+        auto begin = std::chrono::steady_clock::now();
+        lox.run(static_cast<int>(argv.size()), argv.data());
+        return secondsSince(begin);
+    }
+
+    #ifndef _WIN32
+    // one process per script, output thrown away, -1 if any failed
+    double runProcesses(const std::string& interpreter, const std::vector<std::string>& files)
+    {
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+        auto begin = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (const std::string& file : files)
+        {
+            std::string program = interpreter, script = file;
+            char* argv[] = {program.data(), script.data(), nullptr};
+            pid_t pid;
+            int status = 0;
+            ok = ok && posix_spawn(&pid, argv[0], &actions, nullptr, argv, environ) == 0 &&
+                 ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+        double seconds = secondsSince(begin);
+        posix_spawn_file_actions_destroy(&actions);
+        return ok ? seconds : -1;
+    }
+    #endif
+}
+
+int main(int argc, char* argv[])
+{
+    int scriptCount = argc > 1 ? std::atoi(argv[1]) : 2000;
+    std::string interpreter = argc > 2 ? argv[2] : "./main";
+    unsigned int maxThreads = std::thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 1;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "lox_bench_batch";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> files;
+    for (int i = 0; i < scriptCount; i++)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%06d.lox", i);
+        files.push_back((directory / name).string());
+        std::ofstream(files.back()) << SCRIPTS[i % (sizeof(SCRIPTS) / sizeof(SCRIPTS[0]))];
+    }
+
+    std::printf("%d scripts, %u hardware threads\n", scriptCount, maxThreads);
+    int status = EXIT_SUCCESS;
+    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        double seconds = runBatch(directory.string(), threads);
+        std::printf("batch, %2u threads   %8.0f scripts/s\n", threads, scriptCount / seconds);
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+
+    #ifndef _WIN32
+    // a sample is plenty, each launch costs about the same
+    std::vector<std::string> sample(files.begin(), files.begin() + std::min<std::size_t>(files.size(), 200));
+    double seconds = runProcesses(interpreter, sample);
+    if (seconds < 0)
+    {
+        std::fprintf(stderr, "couldn't run %s\n", interpreter.c_str());
+        status = EXIT_FAILURE;
+    }
+    else
+    {
+        std::printf("process per script  %8.0f scripts/s\n", sample.size() / seconds);
+    }
+    #endif
+
+    std::filesystem::remove_all(directory);
+    return status;
+}
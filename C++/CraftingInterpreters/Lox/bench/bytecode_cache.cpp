@@ -0,0 +1,84 @@
+// Cold start of a large script: scanning, parsing and compiling it against
+// loading what an earlier run stored in the BytecodeCache. Each attempt
+// uses a fresh VM, the way every run of the interpreter starts with one.
+// usage: bench/bytecode_cache [megabytes]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include "corpus.h"
+#include "lox/error_reporter.h"
+#include "lox/parser/constant_folder.h"
+#include "lox/parser/parser.h"
+#include "lox/vm/bytecode_cache.h"
+#include "lox/vm/vm.h"
+
+namespace
+{
+    LoxFunction* compile(VM& vm, ErrorReporter& errors, std::string_view source)
+    {
+        Heap::CollectionPause pause(vm.getHeap());
+        Arena arena;
+        Scanner scanner(source, errors, &vm.getHeap());
+        TokenStream tokens(scanner);
+        Parser parser(tokens, arena, errors);
+        NodeList<Stmt*> statements = parser.parse();
+        if (errors.hadError()) std::exit(65);
+
+        ConstantFolder folder(arena);
+        folder.fold(statements);
+        return vm.compile(statements);
+    }
+
+    double seconds(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2;
+    std::string source = generateCorpus(megabytes << 20);
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "lox_bench_cache";
+    std::filesystem::remove_all(directory);
+    BytecodeCache cache(directory.string());
+
+    double compileTime = 1e9;
+    for (int i = 0; i < 3; i++)
+    {
+        ErrorReporter errors;
+        VM vm(errors);
+        auto begin = std::chrono::steady_clock::now();
+        LoxFunction* script = compile(vm, errors, source);
+        compileTime = std::min(compileTime, seconds(begin));
+        if (script == nullptr) return 65;
+        if (i == 0) cache.store("corpus", source, script, vm.getGlobals());
+    }
+
+    double loadTime = 1e9;
+    for (int i = 0; i < 3; i++)
+    {
+        ErrorReporter errors;
+        VM vm(errors);
+        auto begin = std::chrono::steady_clock::now();
+        LoxFunction* script = vm.load(cache, "corpus", source);
+        loadTime = std::min(loadTime, seconds(begin));
+        if (script == nullptr)
+        {
+            std::fprintf(stderr, "cache entry wasn't loaded\n");
+            return 1;
+        }
+    }
+
+    // one byte different and the entry no longer applies
+    source.back() = source.back() == ' ' ? '\n' : ' ';
+    ErrorReporter errors;
+    VM vm(errors);
+    bool stale = vm.load(cache, "corpus", source) != nullptr;
+    std::filesystem::remove_all(directory);
+
+    std::printf("%zu MB script  compile %.3f s  cached %.3f s  (%.1fx)  edited source %s\n",
+                megabytes, compileTime, loadTime, compileTime / loadTime, stale ? "HIT" : "missed");
+    return stale ? 1 : EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+// Many independent interpreters at once on a thread pool, the way an
+// embedder runs them. Every script either runs cleanly, has a syntax error
+// or has a runtime error, each naming its own line and variable, and every
+// interpreter writes its errors to a stream of its own. The run fails if any
+// interpreter's errors don't match its own script exactly, which is what
+// error state shared between instances would show up as.
+// usage: bench/concurrent_instances [scripts] [rounds] [threads]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lox/lox.h"
+#include "lox/util/thread_pool.h"
+
+namespace
+{
+    enum class Outcome { CLEAN, SYNTAX_ERROR, RUNTIME_ERROR };
+
+    struct Script
+    {
+        Outcome outcome;
+        std::string source;
+        std::string diagnostics; // exactly what its interpreter should report
+    };
+
+    // enough work that the interpreters overlap, and garbage for the collector
+    const char* const WORK = R"(
+var s = "";
+var n = 0;
+for (var i = 0; i < 2000; i = i + 1) {
+    s = s + "x";
+    n = n + 1;
+    if (n == 64) { s = ""; n = 0; }
+}
+)";
+
+    Script makeScript(int i)
+    {
+        Script script;
+        script.outcome = static_cast<Outcome>(i % 3);
+        // the error lands on a line of its own, after i blank ones
+        std::string padding(i, '\n');
+        std::string name = "missing" + std::to_string(i);
+        int errorLine = i + 1;
+        switch (script.outcome)
+        {
+            case Outcome::CLEAN:
+                script.source = std::string(WORK) + "var " + name + " = 1;\n";
+                break;
+            case Outcome::SYNTAX_ERROR:
+                script.source = padding + "var " + name + " = ;\n" + WORK;
+                script.diagnostics = "[Line " + std::to_string(errorLine) + "] Error at ';': Expect expression.\n";
+                break;
+            case Outcome::RUNTIME_ERROR:
+                script.source = padding + "var v = " + name + ";\n" + WORK;
+                script.diagnostics = "Undefined variable '" + name + "'.\n[Line " + std::to_string(errorLine) + "] in script\n";
+                break;
+        }
+        return script;
+    }
+
+    bool runScript(const Script& script)
+    {
+        std::ostringstream output, diagnostics;
+        Lox lox(output, diagnostics);
+        lox.run(script.source);
+        return lox.hadError() == (script.outcome == Outcome::SYNTAX_ERROR) &&
+               lox.hadRuntimeError() == (script.outcome == Outcome::RUNTIME_ERROR) &&
+               diagnostics.str() == script.diagnostics;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int scriptCount = argc > 1 ? std::atoi(argv[1]) : 300;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    unsigned int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    std::vector<Script> scripts;
+    for (int i = 0; i < scriptCount; i++) scripts.push_back(makeScript(i));
+
+    ThreadPool pool(threads);
+    std::atomic<int> mismatches{0};
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (const Script& script : scripts)
+        {
+            pool.submit([&script, &mismatches]
+            {
+                if (!runScript(script)) mismatches++;
+            });
+        }
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::printf("%d interpreters on %u threads  %.3f s  %d with the wrong errors\n",
+                scriptCount * rounds, pool.size(), seconds, mismatches.load());
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
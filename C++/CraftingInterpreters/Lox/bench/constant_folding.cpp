@@ -0,0 +1,74 @@
+// The same script compiled with and without the ConstantFolder, comparing
+// the size of the bytecode and how long it takes to run. The loop body is
+// full of arithmetic on literals and of if statements on conditions the
+// folder works out, the way configuration constants end up in real code.
+// usage: bench/constant_folding
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "lox/error_reporter.h"
+#include "lox/parser/constant_folder.h"
+#include "lox/parser/parser.h"
+#include "lox/vm/vm.h"
+
+namespace
+{
+    const char* const SCRIPT = R"(
+        var total = 0;
+        var label = "";
+        for (var i = 0; i < 2000000; i = i + 1) {
+            var seconds = 60 * 60 * 24 * 7;
+            var scale = (1 + 2) * 3 / (4 - 1.5);
+            if (1 < 2) total = total + scale;
+            else total = total - seconds;
+            if (!true) label = "debug " + "build";
+            if (seconds >= 3600 and "a" + "b" == "ab") total = total + 1;
+            while (false) total = 0;
+        }
+    )";
+
+    // everything the script compiled to, counting the code of nested functions too
+    std::size_t codeSize(LoxFunction* function)
+    {
+        std::size_t size = function->chunk.code.size();
+        for (Value constant : function->chunk.constants)
+        {
+            if (constant.isObject() && constant.asObject()->type == ObjectType::FUNCTION)
+            {
+                size += codeSize(static_cast<LoxFunction*>(constant.asObject()));
+            }
+        }
+        return size;
+    }
+
+    void runScript(const char* name, bool fold)
+    {
+        ErrorReporter errors;
+        VM vm(errors);
+        Arena arena;
+        Scanner scanner(SCRIPT, errors);
+        TokenStream tokens(scanner);
+        Parser parser(tokens, arena, errors);
+        NodeList<Stmt*> statements = parser.parse();
+        if (errors.hadError()) std::exit(65);
+
+        ConstantFolder folder(arena);
+        if (fold) folder.fold(statements);
+        LoxFunction* script = vm.compile(statements);
+        if (errors.hadError() || script == nullptr) std::exit(65);
+
+        auto begin = std::chrono::steady_clock::now();
+        if (vm.interpret(script) != InterpretResult::OK) std::exit(70);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        std::printf("%-9s %.3f s  %zu bytes of code  (%d folded, %d dead branches)\n", name, elapsed,
+                    codeSize(script), folder.foldedExpressions(), folder.deadBranches());
+    }
+}
+
+int main()
+{
+    runScript("unfolded", false);
+    runScript("folded", true);
+    return EXIT_SUCCESS;
+}
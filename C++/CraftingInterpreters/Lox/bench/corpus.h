@@ -0,0 +1,22 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+#include <string>
+
+// Synthetic Lox source of roughly the given size for the benchmarks, a mix
+// of comments, declarations, multi-line strings, functions and classes.
+inline std::string generateCorpus(std::size_t bytes)
+{
+    std::string source;
+    source.reserve(bytes + 512);
+    for (int i = 0; source.size() < bytes; i++)
+    {
+        std::string n = std::to_string(i);
+        source += "// block " + n + " generated header comment with a \"quote\" in it\n";
+        source += "var value_" + n + " = " + n + " + " + n + ".5 * counter;\n";
+        source += "fun compute_" + n + "(a, b) {\n    if (a < b and b != nil) return a * b;\n";
+        source += "    return \"string spanning\n    two lines " + n + "\";\n}\n";
+        source += "class Thing_" + n + " { get() { return this.x; } }\n";
+    }
+    return source;
+}
+#endif
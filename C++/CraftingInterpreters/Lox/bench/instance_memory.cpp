@@ -0,0 +1,82 @@
+// Memory per instance with 1M live instances of a 5 field class, plus the
+// time to build them and to read every field back. Reported both as the
+// bytes the Heap counts for them and as the growth in peak RSS, which also
+// covers anything an instance keeps outside its own object.
+// usage: bench/instance_memory
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sys/resource.h>
+#include "lox/error_reporter.h"
+#include "lox/parser/parser.h"
+#include "lox/vm/vm.h"
+
+namespace
+{
+    constexpr long INSTANCES = 1000000;
+
+    // the list keeps every particle alive, next is the fifth field
+    const char* const BUILD = R"(
+        class Particle {
+            init(x, y, vx, vy, next) {
+                this.x = x;
+                this.y = y;
+                this.vx = vx;
+                this.vy = vy;
+                this.next = next;
+            }
+        }
+        var particles = nil;
+        for (var i = 0; i < 1000000; i = i + 1) particles = Particle(i, i, 1, -1, particles);
+    )";
+
+    const char* const READ = R"(
+        var total = 0;
+        var p = particles;
+        while (p != nil) {
+            total = total + p.x + p.y + p.vx + p.vy;
+            p = p.next;
+        }
+    )";
+
+    long peakRssKilobytes()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss; // kilobytes on Linux
+    }
+
+    double runScript(VM& vm, const char* source)
+    {
+        Arena arena;
+        ErrorReporter errors;
+        Scanner scanner(source, errors);
+        TokenStream tokens(scanner);
+        Parser parser(tokens, arena, errors);
+        LoxFunction* script = vm.compile(parser.parse());
+        if (errors.hadError() || script == nullptr) std::exit(65);
+
+        auto begin = std::chrono::steady_clock::now();
+        if (vm.interpret(script) != InterpretResult::OK) std::exit(70);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+}
+
+int main()
+{
+    ErrorReporter errors;
+    VM vm(errors);
+    long rssBefore = peakRssKilobytes();
+    std::size_t heapBefore = vm.getHeap().allocated();
+
+    double build = runScript(vm, BUILD);
+    long rssAfter = peakRssKilobytes();
+    std::size_t heapAfter = vm.getHeap().allocated();
+    double read = runScript(vm, READ);
+
+    std::cout << "build: " << build << " s, read: " << read << " s" << std::endl;
+    std::cout << "heap bytes per instance: " << static_cast<double>(heapAfter - heapBefore) / INSTANCES << std::endl;
+    std::cout << "peak RSS bytes per instance: " << (rssAfter - rssBefore) * 1024.0 / INSTANCES << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+// Allocation heavy Lox scripts under whichever allocator this was built
+// with, build.sh bench builds it twice (with and without LOX_NO_NURSERY)
+// to compare the nursery with every object malloc'ed into the old space.
+// - "strings" builds strings a character at a time, most die straight away
+// - "churn" makes instances and bound methods that never outlive the loop
+// - "retained" keeps a long list alive while churning, so survivors get promoted
+// usage: bench/nursery_on | bench/nursery_off
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include "lox/error_reporter.h"
+#include "lox/parser/parser.h"
+#include "lox/vm/vm.h"
+
+namespace
+{
+    const char* const SCRIPTS[][2] = {
+        {"strings", R"(
+            for (var round = 0; round < 2000; round = round + 1) {
+                var s = "";
+                for (var i = 0; i < 200; i = i + 1) s = s + "x";
+            }
+        )"},
+        {"churn", R"(
+            class Point {
+                init(x, y) { this.x = x; this.y = y; }
+                sum() { return this.x + this.y; }
+            }
+            var total = 0;
+            for (var i = 0; i < 1000000; i = i + 1) {
+                var p = Point(i, 1);
+                var f = p.sum;
+                total = total + f();
+            }
+        )"},
+        {"retained", R"(
+            class Node { init(value, next) { this.value = value; this.next = next; } }
+            var list = nil;
+            var k = 0;
+            for (var i = 0; i < 1000000; i = i + 1) {
+                var garbage = Node(i, nil);
+                k = k + 1;
+                if (k == 10) { k = 0; list = Node(i, list); }
+            }
+        )"},
+    };
+
+    double seconds(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    double runScript(VM& vm, const char* source)
+    {
+        Arena arena;
+        ErrorReporter errors;
+        Scanner scanner(source, errors);
+        TokenStream tokens(scanner);
+        Parser parser(tokens, arena, errors);
+        LoxFunction* script = vm.compile(parser.parse());
+        if (errors.hadError() || script == nullptr) std::exit(65);
+
+        auto begin = std::chrono::steady_clock::now();
+        if (vm.interpret(script) != InterpretResult::OK) std::exit(70);
+        return seconds(begin);
+    }
+}
+
+int main()
+{
+#ifdef LOX_NO_NURSERY
+    std::cout << "allocator: malloc only" << std::endl;
+#else
+    std::cout << "allocator: nursery" << std::endl;
+#endif
+
+    for (const auto& script : SCRIPTS)
+    {
+        // a VM each, so one script's garbage isn't collected on the next one's time
+        ErrorReporter errors;
+        VM vm(errors);
+        double elapsed = runScript(vm, script[1]);
+        const GcStats& stats = vm.getHeap().stats();
+        std::printf("%-9s %.3f s  (%ld minor, %d major cycles, %.1f ms paused, longest %.0f us)\n", script[0], elapsed,
+                    stats.minorCollections, stats.cycles, stats.totalPauseMicros / 1000, stats.maxPauseMicros);
+    }
+
+    return EXIT_SUCCESS;
+}
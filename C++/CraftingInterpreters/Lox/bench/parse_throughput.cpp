@@ -0,0 +1,69 @@
+// Parser throughput and memory on a large script: scanning and parsing
+// into the arena, reported as MB/s, arena size and peak RSS.
+// usage: bench/parse_throughput [script | megabytes]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include "lox/error_reporter.h"
+#include "lox/parser/parser.h"
+#include "lox/source/source_file.h"
+#include "corpus.h"
+
+namespace
+{
+    long peakRssKilobytes()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss; // kilobytes on Linux
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string generated;
+    SourceFile file;
+    std::string_view source;
+
+    std::string arg = argc > 1 ? argv[1] : "64";
+    if (arg.find_first_not_of("0123456789") == std::string::npos)
+    {
+        generated = generateCorpus(std::stoul(arg) * 1024 * 1024);
+        source = generated;
+    }
+    else if (file.open(arg))
+    {
+        source = file.view();
+    }
+    else
+    {
+        std::cerr << "Can't open " << arg << std::endl;
+        return 66;
+    }
+
+    long rssBefore = peakRssKilobytes();
+    auto begin = std::chrono::steady_clock::now();
+
+    Arena arena;
+    ErrorReporter errors;
+    Scanner scanner(source, errors);
+    TokenStream tokens(scanner);
+    Parser parser(tokens, arena, errors);
+    NodeList<Stmt*> statements = parser.parse();
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    double megabytes = source.size() / (1024.0 * 1024.0);
+
+    std::cout << "source: " << megabytes << " MB, " << statements.size() << " top level statements"
+              << (errors.hadError() ? " (with errors)" : "") << std::endl;
+    std::cout << "parse: " << seconds << " s, " << megabytes / seconds << " MB/s" << std::endl;
+    std::cout << "arena: " << arena.bytesUsed() / (1024.0 * 1024.0) << " MB used, "
+              << arena.bytesReserved() / (1024.0 * 1024.0) << " MB reserved" << std::endl;
+    std::cout << "peak RSS: " << peakRssKilobytes() / 1024.0 << " MB ("
+              << (peakRssKilobytes() - rssBefore) / 1024.0 << " MB while parsing)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
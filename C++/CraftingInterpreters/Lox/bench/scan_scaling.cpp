@@ -0,0 +1,70 @@
+// Scanner throughput on a synthetic corpus, sequential vs ParallelScanner
+// with 1 up to N threads. Also checks every run produced the same tokens.
+// usage: bench/scan_scaling [megabytes] [max threads]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "lox/scanner/scanner.h"
+#include "lox/scanner/parallel_scanner.h"
+#include "corpus.h"
+
+namespace
+{
+    bool sameTokens(const std::vector<Token>& a, const std::vector<Token>& b)
+    {
+        if (a.size() != b.size()) return false;
+        for (std::size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i].type != b[i].type || a[i].line != b[i].line ||
+                a[i].lexeme.data() != b[i].lexeme.data() || a[i].lexeme.size() != b[i].lexeme.size())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename F>
+    double bestSeconds(F&& scan)
+    {
+        double best = 1e9;
+        for (int run = 0; run < 5; run++)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            scan();
+            auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(end - begin).count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t megabytes = argc > 1 ? std::atoi(argv[1]) : 200;
+    unsigned int maxThreads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    if (maxThreads == 0) maxThreads = 1;
+
+    std::string source = generateCorpus(megabytes * 1024 * 1024);
+    std::cout << "corpus: " << source.size() / (1024.0 * 1024.0) << " MB, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    ErrorReporter errors;
+    std::vector<Token> expected;
+    double sequential = bestSeconds([&] { expected = Scanner(source, errors).scanTokens(); });
+    std::cout << "sequential: " << sequential << " s, " << expected.size() << " tokens" << std::endl;
+
+    for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ThreadPool pool(threads);
+        std::vector<Token> tokens;
+        double seconds = bestSeconds([&] { tokens = ParallelScanner(source, pool, errors).scanTokens(); });
+        std::cout << threads << " threads: " << seconds << " s, speedup " << sequential / seconds
+                  << (sameTokens(expected, tokens) ? "" : "  MISMATCH") << std::endl;
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+// Startup latency of the interpreter as a separate process, the way it's
+// run once per request:
+// - first token: launch with --tokens on a one line script and wait for
+//   the first byte of the dump on a pipe
+// - empty script: launch on an empty file and wait for it to exit
+// Each is run many times, the median and fastest are reported.
+// usage: bench/startup [interpreter] [runs]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Timings
+    {
+        std::vector<double> runs;
+
+        void print(const char* name)
+        {
+            std::sort(runs.begin(), runs.end());
+            std::printf("%-13s median %7.1f us  fastest %7.1f us\n", name, runs[runs.size() / 2], runs.front());
+        }
+    };
+
+    double microseconds(Clock::time_point begin)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+    }
+
+    #ifndef _WIN32
+    // microseconds from launching until the first byte on stdout, or until exit
+    // when firstByte is false, -1 if it couldn't be run
+    double launch(std::vector<std::string> args, bool firstByte)
+    {
+        std::vector<char*> argv;
+        for (std::string& arg : args) argv.push_back(arg.data());
+        argv.push_back(nullptr);
+
+        int out[2];
+        if (::pipe(out) != 0) return -1;
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addclose(&actions, out[0]);
+
+        pid_t pid;
+        Clock::time_point begin = Clock::now();
+        int spawned = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(out[1]);
+        if (spawned != 0)
+        {
+            ::close(out[0]);
+            return -1;
+        }
+
+        double elapsed = -1;
+        char buffer[4096];
+        if (firstByte && ::read(out[0], buffer, 1) == 1) elapsed = microseconds(begin);
+        // drained so the child never blocks on a full pipe
+        while (::read(out[0], buffer, sizeof(buffer)) > 0) {}
+        int status;
+        ::waitpid(pid, &status, 0);
+        if (!firstByte) elapsed = microseconds(begin);
+        ::close(out[0]);
+
+        bool exitedCleanly = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        return exitedCleanly ? elapsed : -1;
+    }
+    #endif
+}
+
+int main(int argc, char* argv[])
+{
+    #ifdef _WIN32
+    std::printf("startup: needs posix_spawn, not run on Windows\n");
+    return EXIT_SUCCESS;
+    #else
+    std::string interpreter = argc > 1 ? argv[1] : "./main";
+    int runs = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string empty = (directory / "lox_startup_empty.lox").string();
+    std::string oneLine = (directory / "lox_startup_line.lox").string();
+    std::ofstream(empty).close();
+    std::ofstream(oneLine) << "print \"hello\";\n";
+
+    Timings firstToken, emptyScript;
+    for (int i = 0; i < runs; i++)
+    {
+        double token = launch({interpreter, "--tokens", oneLine}, true);
+        double exit = launch({interpreter, empty}, false);
+        if (token < 0 || exit < 0)
+        {
+            std::fprintf(stderr, "couldn't run %s\n", interpreter.c_str());
+            return EXIT_FAILURE;
+        }
+        firstToken.runs.push_back(token);
+        emptyScript.runs.push_back(exit);
+    }
+
+    std::remove(empty.c_str());
+    std::remove(oneLine.c_str());
+    std::printf("%s, %d runs\n", interpreter.c_str(), runs);
+    firstToken.print("first token");
+    emptyScript.print("empty script");
+    return EXIT_SUCCESS;
+    #endif
+}
@@ -0,0 +1,98 @@
+// Scripts that lean on the sequences the peephole pass fuses, under
+// whichever build this is. build.sh bench builds it three ways: with and
+// without LOX_NO_SUPERINSTRUCTIONS to compare times, and with
+// LOX_DISPATCH_STATS to count dispatches, which is too slow to time.
+// - "calls" is recursive fib, locals against constants and compare and branch
+// - "loops" counts up locals in for and while loops
+// - "fields" reads fields through this and through other locals
+// usage: bench/superinstructions_on | bench/superinstructions_off | bench/superinstructions_count
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "lox/error_reporter.h"
+#include "lox/parser/parser.h"
+#include "lox/vm/vm.h"
+
+namespace
+{
+    const char* const SCRIPTS[][2] = {
+        {"calls", R"(
+            fun fib(n) {
+                if (n < 2) return n;
+                return fib(n - 2) + fib(n - 1);
+            }
+            fib(27);
+        )"},
+        {"loops", R"(
+            {
+                var total = 0;
+                for (var i = 0; i < 3000000; i = i + 1) {
+                    var j = 0;
+                    while (j < 3) j = j + 1;
+                    total = total + j;
+                }
+            }
+        )"},
+        {"fields", R"(
+            class Vec {
+                init(x, y) { this.x = x; this.y = y; }
+                dot(other) { return this.x * other.x + this.y * other.y; }
+            }
+            {
+                var a = Vec(1, 2);
+                var b = Vec(3, 4);
+                var sum = 0;
+                for (var i = 0; i < 1000000; i = i + 1) sum = sum + a.dot(b);
+            }
+        )"},
+    };
+
+    double seconds(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    double runScript(VM& vm, const char* source)
+    {
+        Arena arena;
+        ErrorReporter errors;
+        Scanner scanner(source, errors);
+        TokenStream tokens(scanner);
+        Parser parser(tokens, arena, errors);
+        LoxFunction* script = vm.compile(parser.parse());
+        if (errors.hadError() || script == nullptr) std::exit(65);
+
+        auto begin = std::chrono::steady_clock::now();
+        if (vm.interpret(script) != InterpretResult::OK) std::exit(70);
+        return seconds(begin);
+    }
+}
+
+int main()
+{
+#if defined(LOX_DISPATCH_STATS)
+    std::cout << "superinstructions: on, counting dispatches" << std::endl;
+#elif defined(LOX_NO_SUPERINSTRUCTIONS)
+    std::cout << "superinstructions: off" << std::endl;
+#else
+    std::cout << "superinstructions: on" << std::endl;
+#endif
+
+    for (const auto& script : SCRIPTS)
+    {
+        ErrorReporter errors;
+        VM vm(errors);
+        double elapsed = runScript(vm, script[1]);
+#ifdef LOX_DISPATCH_STATS
+        // the first line of the report is the totals
+        std::string report = vm.dispatchStats().report();
+        std::printf("%-7s %s", script[0], report.substr(0, report.find('\n') + 1).c_str());
+#else
+        std::printf("%-7s %.3f s\n", script[0], elapsed);
+#endif
+    }
+
+    return EXIT_SUCCESS;
+}
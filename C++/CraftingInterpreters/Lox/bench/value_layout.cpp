@@ -0,0 +1,107 @@
+// Arithmetic heavy loops under whichever Value layout this was built with,
+// build.sh bench builds it twice (with and without LOX_TAGGED_VALUES) to
+// compare NaN boxing with the tagged union.
+// - "values" works on a plain array of Values the way the VM's stack does
+// - the rest are Lox scripts compiled and run on the VM
+// usage: bench/value_layout_nan | bench/value_layout_tagged
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "lox/error_reporter.h"
+#include "lox/parser/parser.h"
+#include "lox/vm/vm.h"
+
+namespace
+{
+    const char* const SCRIPTS[][2] = {
+        {"sum", R"(
+            var total = 0;
+            for (var i = 0; i < 3000000; i = i + 1) total = total + i * 2 - 1;
+        )"},
+        {"locals", R"(
+            {
+                var a = 1; var b = 2; var c = 0;
+                for (var i = 0; i < 3000000; i = i + 1) {
+                    c = (a + b) * c / 3 - a;
+                    if (c > 1000 or c < -1000) c = 0;
+                }
+            }
+        )"},
+        {"calls", R"(
+            fun mix(x, y) { return (x + y) * (x - y); }
+            var acc = 0;
+            for (var i = 0; i < 1000000; i = i + 1) acc = acc + mix(i, 3);
+        )"},
+    };
+
+    double seconds(std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    // adds, compares and truthiness checks over an array with a few non numbers mixed in
+    double valueLoop()
+    {
+        std::vector<Value> values(4096);
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            values[i] = i % 64 == 0 ? Value::boolean(i % 128 == 0) : Value::number(static_cast<double>(i));
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        Value sum = Value::number(0);
+        int truthy = 0;
+        for (int round = 0; round < 5000; round++)
+        {
+            for (const Value& value : values)
+            {
+                if (value.isNumber())
+                {
+                    double next = sum.asNumber() + value.asNumber();
+                    sum = Value::number(next > 1e12 ? 0 : next);
+                }
+                if (!value.isFalsey()) truthy++;
+            }
+        }
+        double elapsed = seconds(begin);
+
+        if (truthy == 0) std::cout << sum.toString() << std::endl; // keep the loop from being optimised out
+        return elapsed;
+    }
+
+    double runScript(VM& vm, const char* source)
+    {
+        Arena arena;
+        ErrorReporter errors;
+        Scanner scanner(source, errors);
+        TokenStream tokens(scanner);
+        Parser parser(tokens, arena, errors);
+        LoxFunction* script = vm.compile(parser.parse());
+        if (errors.hadError() || script == nullptr) std::exit(65);
+
+        auto begin = std::chrono::steady_clock::now();
+        if (vm.interpret(script) != InterpretResult::OK) std::exit(70);
+        return seconds(begin);
+    }
+}
+
+int main()
+{
+#ifdef LOX_TAGGED_VALUES
+    const char* layout = "tagged union";
+#else
+    const char* layout = "NaN boxed";
+#endif
+    std::cout << "layout: " << layout << ", sizeof(Value) = " << sizeof(Value) << std::endl;
+    std::cout << "values: " << valueLoop() << " s" << std::endl;
+
+    ErrorReporter errors;
+    VM vm(errors);
+    for (const auto& script : SCRIPTS)
+    {
+        std::cout << script[0] << ": " << runScript(vm, script[1]) << " s" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,4 +1,64 @@
 #g++ -I src -o main src/**/*.cpp
-g++ -I src -o main src/lox/scanner/scanner.cpp src/main.cpp \
-src/lox/lox.cpp src/lox/scanner/token.cpp src/lox/scanner/token_type.cpp \
-src/lox/types/lox_string.cpp src/lox/types/number.cpp
\ No newline at end of file
+# usage: ./build.sh [bench]
+SOURCES="src/lox/lox.cpp src/lox/error_reporter.cpp src/lox/scanner/scanner.cpp \
+src/lox/scanner/token.cpp \
+src/lox/types/lox_string.cpp src/lox/types/value.cpp \
+src/lox/types/lox_function.cpp src/lox/types/lox_native.cpp \
+src/lox/types/lox_class.cpp src/lox/types/lox_instance.cpp \
+src/lox/types/lox_bound_method.cpp src/lox/types/shape.cpp \
+src/lox/types/lox_closure.cpp src/lox/types/lox_upvalue.cpp \
+src/lox/source/source_file.cpp src/lox/scanner/byte_scan.cpp \
+src/lox/scanner/token_stream.cpp src/lox/scanner/parallel_scanner.cpp \
+src/lox/util/thread_pool.cpp src/lox/util/work_stealing_pool.cpp src/lox/scanner/token_writer.cpp \
+src/lox/util/arena.cpp src/lox/parser/parser.cpp src/lox/parser/ast_printer.cpp \
+src/lox/parser/constant_folder.cpp src/lox/vm/chunk.cpp src/lox/vm/heap.cpp src/lox/vm/compiler.cpp \
+src/lox/vm/vm.cpp src/lox/vm/debug.cpp src/lox/vm/table.cpp \
+src/lox/vm/globals.cpp src/lox/vm/inline_cache.cpp src/lox/vm/dispatch_stats.cpp \
+src/lox/vm/peephole.cpp src/lox/vm/bytecode_cache.cpp"
+
+g++ -std=c++17 -O2 -pthread -I src -o main src/main.cpp $SOURCES || exit 1
+
+if [ "$1" = "bench" ]; then
+    g++ -std=c++17 -O2 -pthread -I src -o bench/scan_scaling bench/scan_scaling.cpp $SOURCES || exit 1
+    g++ -std=c++17 -O2 -pthread -I src -o bench/parse_throughput bench/parse_throughput.cpp $SOURCES || exit 1
+
+    # the whole interpreter is rebuilt for each Value layout
+    g++ -std=c++17 -O2 -pthread -I src -o bench/value_layout_nan bench/value_layout.cpp $SOURCES || exit 1
+    g++ -std=c++17 -O2 -pthread -I src -DLOX_TAGGED_VALUES -o bench/value_layout_tagged bench/value_layout.cpp $SOURCES || exit 1
+    bench/value_layout_nan && bench/value_layout_tagged || exit 1
+
+    # and for each allocator
+    g++ -std=c++17 -O2 -pthread -I src -o bench/nursery_on bench/nursery.cpp $SOURCES || exit 1
+    g++ -std=c++17 -O2 -pthread -I src -DLOX_NO_NURSERY -o bench/nursery_off bench/nursery.cpp $SOURCES || exit 1
+    bench/nursery_on && bench/nursery_off || exit 1
+
+    g++ -std=c++17 -O2 -pthread -I src -o bench/instance_memory bench/instance_memory.cpp $SOURCES || exit 1
+    bench/instance_memory || exit 1
+
+    # timed with and without the peephole pass, then counted
+    g++ -std=c++17 -O2 -pthread -I src -o bench/superinstructions_on bench/superinstructions.cpp $SOURCES || exit 1
+    g++ -std=c++17 -O2 -pthread -I src -DLOX_NO_SUPERINSTRUCTIONS -o bench/superinstructions_off bench/superinstructions.cpp $SOURCES || exit 1
+    g++ -std=c++17 -O2 -pthread -I src -DLOX_DISPATCH_STATS -o bench/superinstructions_count bench/superinstructions.cpp $SOURCES || exit 1
+    bench/superinstructions_on && bench/superinstructions_off && bench/superinstructions_count || exit 1
+
+    g++ -std=c++17 -O2 -pthread -I src -o bench/constant_folding bench/constant_folding.cpp $SOURCES || exit 1
+    bench/constant_folding || exit 1
+
+    g++ -std=c++17 -O2 -pthread -I src -o bench/bytecode_cache bench/bytecode_cache.cpp $SOURCES || exit 1
+    bench/bytecode_cache || exit 1
+
+    g++ -std=c++17 -O2 -pthread -I src -o bench/concurrent_instances bench/concurrent_instances.cpp $SOURCES || exit 1
+    bench/concurrent_instances || exit 1
+
+    g++ -std=c++17 -O2 -pthread -I src -o bench/batch_throughput bench/batch_throughput.cpp $SOURCES || exit 1
+    bench/batch_throughput 2000 ./main || exit 1
+
+    g++ -std=c++17 -O2 -o bench/startup bench/startup.cpp || exit 1
+    bench/startup ./main || exit 1
+
+    # each script prints its own elapsed time
+    for script in bench/*.lox; do
+        echo "== $script"
+        ./main "$script" || exit 1
+    done
+fi
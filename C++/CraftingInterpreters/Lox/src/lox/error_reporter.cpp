@@ -0,0 +1,38 @@
+#include "error_reporter.h"
+
+ErrorReporter::ErrorReporter(std::ostream& out): out(out) {}
+
+void ErrorReporter::error(int line, std::string_view message)
+{
+    report(line, "", message);
+}
+
+void ErrorReporter::error(const Token& token, std::string_view message)
+{
+    if (token.type == TokenType::END)
+    {
+        report(token.line, "at end", message);
+    }
+    else
+    {
+        report(token.line, "at '" + std::string(token.lexeme) + "'", message);
+    }
+}
+
+void ErrorReporter::runtimeError(std::string_view report)
+{
+    out << report << std::flush;
+    runtimeErrors = true;
+}
+
+void ErrorReporter::reset()
+{
+    compileErrors = false;
+    runtimeErrors = false;
+}
+
+void ErrorReporter::report(int line, std::string_view where, std::string_view message)
+{
+    out << "[Line " << line << "] Error " << where << ": " << message << std::endl;
+    compileErrors = true;
+}
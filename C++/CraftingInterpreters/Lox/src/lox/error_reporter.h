@@ -0,0 +1,36 @@
+#ifndef ERROR_REPORTER_H
+#define ERROR_REPORTER_H
+#include <iostream>
+#include <string_view>
+#include "lox/scanner/token.h"
+
+// Where one interpreter's errors are written and whether it has had any.
+// Each Lox owns one and hands it to its Scanner, Parser, Compiler and VM,
+// so interpreters running on different threads never see each other's
+// errors, and an embedder can send an interpreter's diagnostics to a
+// stream of its own.
+class ErrorReporter
+{
+    public:
+        // out must outlive the reporter
+        explicit ErrorReporter(std::ostream& out = std::cerr);
+
+        // compile errors, from scanning, parsing or compiling
+        void error(int line, std::string_view message);
+        void error(const Token& token, std::string_view message);
+        // a runtime error's message and stack trace, formatted by the VM
+        void runtimeError(std::string_view report);
+
+        bool hadError() const { return compileErrors; }
+        bool hadRuntimeError() const { return runtimeErrors; }
+        // forgets earlier errors, the REPL does this between lines
+        void reset();
+
+    private:
+        void report(int line, std::string_view where, std::string_view message);
+
+        std::ostream& out;
+        bool compileErrors = false;
+        bool runtimeErrors = false;
+};
+#endif
@@ -1,24 +1,129 @@
 #include <iostream>
-#include <fstream>
-#include <locale>
-#include <codecvt>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 #include "lox.h"
 #include "lox/scanner/scanner.h"
+#include "lox/scanner/parallel_scanner.h"
+#include "lox/scanner/token_writer.h"
+#include "lox/scanner/token_stream.h"
+#include "lox/parser/parser.h"
+#include "lox/parser/ast_printer.h"
+#include "lox/parser/constant_folder.h"
+#include "lox/util/arena.h"
+#include "lox/util/work_stealing_pool.h"
+#include "lox/source/source_file.h"
+#include "lox/vm/debug.h"
+
+Lox::Lox(std::ostream& output, std::ostream& errorOutput):
+    output(output), errorOutput(errorOutput), reporter(errorOutput), vm(reporter, output) {}
 
 void Lox::run(int argc, char* argv[])
 {
-    if (argc > 2)
+    // options come before the script name
+    int arg = 1;
+    for (; arg < argc && std::string_view(argv[arg]).substr(0, 2) == "--"; arg++)
     {
-        // std::cout << "Usage: jlox [script]" << std::endl;
-        std::cerr << "Usage: jlox [script]" << std::endl;
-        std::exit(64);
-        // exit codes defined: https://man.freebsd.org/cgi/man.cgi?query=sysexits&apropos=0&sektion=0&manpath=FreeBSD+4.3-RELEASE&format=html
-        // - 64: Command used incorrectly
-        // std::exit() indicates a normal end to a program, although can still indicate failure
+        std::string_view option(argv[arg]);
+        if (option == "--jobs" && arg + 1 < argc)
+        {
+            // scan large files, or run a batch's scripts, on this many threads
+            jobs = std::atoi(argv[++arg]);
+            if (jobs < 1) usage();
+        }
+        else if (option == "--batch")
+        {
+            // run every script named after the options at once, each in an interpreter of its own
+            batch = true;
+        }
+        else if (option == "--tokens")
+        {
+            // scan and dump the tokens instead of running the script
+            mode = Mode::TOKENS;
+        }
+        else if (option == "--binary-tokens")
+        {
+            // dump tokens in TokenWriter's compact binary format
+            mode = Mode::TOKENS;
+            tokenFormat = TokenWriter::Format::BINARY;
+        }
+        else if (option == "--ast")
+        {
+            // parse and print the syntax tree instead of the tokens
+            mode = Mode::AST;
+        }
+        else if (option == "--disassemble")
+        {
+            // compile and print the bytecode instead of running it
+            mode = Mode::DISASSEMBLE;
+        }
+        else if (option == "--gc-stats")
+        {
+            // print collector pause times to stderr once the script has run
+            gcStats = true;
+        }
+        else if (option == "--ic-stats")
+        {
+            // print inline cache hit rates to stderr once the script has run
+            icStats = true;
+        }
+        else if (option == "--dispatch-stats")
+        {
+            // print instruction and instruction pair counts to stderr once the script has run
+            dispatchStats = true;
+        }
+        else if (option == "--fold-stats")
+        {
+            // print how much the constant folder found to stderr once the script has run
+            foldStats = true;
+        }
+        else if (option == "--cache" && arg + 1 < argc)
+        {
+            // keep compiled scripts in this directory and run them from there while their source is unchanged
+            cacheDirectory = argv[++arg];
+        }
+        else if (option == "--gc-growth" && arg + 1 < argc)
+        {
+            // start a collection once the heap has grown by this factor since the last one
+            gcGrowth = std::atof(argv[++arg]);
+            if (gcGrowth <= 1) usage();
+        }
+        else if (option == "--gc-pause-us" && arg + 1 < argc)
+        {
+            // longest a single collector step should take
+            gcPauseMicros = std::atoi(argv[++arg]);
+            if (gcPauseMicros < 0) usage();
+        }
+        else
+        {
+            usage();
+        }
     }
-    else if (argc == 2)
+
+    vm.getHeap().setPacing(gcGrowth, gcPauseMicros);
+
+    if (batch)
     {
-        std::string fileName(argv[1]);
+        if (argc - arg == 0) usage();
+        int status = runBatch(std::vector<std::string>(argv + arg, argv + argc));
+        if (status != EXIT_SUCCESS) std::exit(status);
+    }
+    else if (argc - arg > 1)
+    {
+        usage();
+    }
+    else if (argc - arg == 1)
+    {
+        std::string fileName(argv[arg]);
         this->runFile(fileName);
     }
     else
@@ -27,83 +132,312 @@ void Lox::run(int argc, char* argv[])
     }
 }
 
-void Lox::run(const std::string& data)
+void Lox::usage()
 {
-    // std::cout << data << std::endl;
-    Scanner sc(data);
-    std::vector<Token> tokens = sc.scanTokens();
+    // std::cout << "Usage: jlox [script]" << std::endl;
+    std::cerr << "Usage: jlox [--tokens | --binary-tokens | --ast | --disassemble] [--jobs n]\n"
+              << "            [--gc-stats] [--gc-growth factor] [--gc-pause-us n] [--ic-stats] [--fold-stats]\n"
+              << "            [--dispatch-stats] [--cache dir] [script | -]\n"
+              << "       jlox --batch [options] (script | dir)..." << std::endl;
+    std::exit(64);
+    // exit codes defined: https://man.freebsd.org/cgi/man.cgi?query=sysexits&apropos=0&sektion=0&manpath=FreeBSD+4.3-RELEASE&format=html
+    // - 64: Command used incorrectly
+    // std::exit() indicates a normal end to a program, although can still indicate failure
+}
 
-    // can't use for (Token token : tokens) as it tries to make a copy
-    // of each Token but can't as it contains std::unique_prt<Object>.
-    // - using const Token& prevents attempting to copy the objects
-    for (const Token& token : tokens)
+void Lox::run(std::string_view source)
+{
+    // std::cout << source << std::endl;
+    switch (mode)
     {
-        std::cout << token.toString() << std::endl;
+        case Mode::RUN:
+        case Mode::DISASSEMBLE: interpret(source); break;
+        case Mode::TOKENS: dumpTokens(source); break;
+        case Mode::AST: printAst(source); break;
     }
+}
+
+void Lox::interpret(std::string_view source)
+{
+    LoxFunction* script = compile(source);
+    if (script == nullptr) return;
 
+    if (mode == Mode::DISASSEMBLE)
+    {
+        Disassembler disassembler(vm.getGlobals());
+        output << disassembler.disassemble(script);
+        return;
+    }
 
+    vm.interpret(script);
 }
 
-void Lox::runFile(std::string fileName)
+LoxFunction* Lox::compile(std::string_view source)
+{
+    // the tree is only needed until it's compiled, the bytecode and its
+    // constants live on the VM's heap
+    // - the only references to the strings the scanner interns are in the
+    //   tree, so nothing is collected until it's compiled
+    Heap::CollectionPause pause(vm.getHeap());
+    if (cache)
+    {
+        if (LoxFunction* script = vm.load(*cache, cacheKey, source)) return script;
+    }
+
+    // a large script is scanned on --jobs threads first and the parser reads the tokens back
+    // - identifiers from those threads aren't interned, the compiler interns them as it meets them
+    // - all the scan errors are reported before any parse error, rather than in source order
+    std::vector<Token> scanned;
+    std::optional<Scanner> sc;
+    if (scanInParallel(source))
+    {
+        ThreadPool pool(jobs);
+        scanned = ParallelScanner(source, pool, reporter).scanTokens();
+    }
+    else
+    {
+        sc.emplace(source, reporter, &vm.getHeap());
+    }
+
+    Arena arena;
+    TokenStream tokens = sc ? TokenStream(*sc) : TokenStream(scanned);
+    Parser parser(tokens, arena, reporter);
+    NodeList<Stmt*> statements = parser.parse();
+    if (reporter.hadError()) return nullptr;
+
+    ConstantFolder folder(arena);
+    folder.fold(statements);
+    foldedExpressions += folder.foldedExpressions();
+    deadBranches += folder.deadBranches();
+
+    LoxFunction* script = vm.compile(statements);
+    if (cache && script) cache->store(cacheKey, source, script, vm.getGlobals());
+    return script;
+}
+
+void Lox::printAst(std::string_view source)
 {
-    std::string fileData = this->readFile(fileName);
-    this->run(fileData);
-    if (Lox::hadError) std::exit(65);
+    // every node of this script lives in the arena and is freed with it in one go
+    Arena arena;
+    Scanner sc(source, reporter);
+    TokenStream tokens(sc);
+    Parser parser(tokens, arena, reporter);
+    NodeList<Stmt*> statements = parser.parse();
+
+    if (reporter.hadError()) return;
+
+    AstPrinter printer;
+    output << printer.print(statements);
 }
 
-void Lox::runPrompt()
+void Lox::dumpTokens(std::string_view source)
 {
-    for (;;)
+    if (tokenFormat == TokenWriter::Format::BINARY)
     {
-        std::cout << "> ";
-        std::string line;
-        // std::cin >> line;
-        // std::cin only reads input until it encounters whitespace (spaces, tabs, newlines)
-        // - causes hang on checking if empty for exit
-        std::getline(std::cin, line); // this reads the whole line, including whitespace
+        #ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY); // stop '\n' bytes being turned into "\r\n"
+        #endif
+    }
+    TokenWriter writer(output, tokenFormat);
 
-        if (line.empty()) break;
-        run(line);
-        Lox::hadError = false;
+    if (scanInParallel(source))
+    {
+        // the chunks have to be stitched together, so this mode holds every token at once
+        ThreadPool pool(jobs);
+        ParallelScanner sc(source, pool, reporter);
+        for (const Token& token : sc.scanTokens())
+        {
+            writer.write(token);
+        }
+        return;
+    }
+
+    Scanner sc(source, reporter);
+
+    // tokens are pulled one at a time, a large script never has its
+    // whole token list in memory
+    for (Token token = sc.nextToken(); ; token = sc.nextToken())
+    {
+        writer.write(token);
+        if (token.type == TokenType::END) break;
     }
 }
 
-// I have no idea if this will work, need to mess about with it and test
-std::string Lox::readFile(const std::string& fileName)
+// only worth it when the source splits into at least two chunks
+bool Lox::scanInParallel(std::string_view source) const
 {
-    std::ifstream file(fileName, std::ios::in | std::ios::binary); // open file in binary mode, prevents newline translation
+    return jobs > 1 && source.size() >= 2 * ParallelScanner::MIN_CHUNK_SIZE;
+}
 
-    if (!file.is_open())
+void Lox::runFile(std::string fileName)
+{
+    int status = runScript(fileName);
+    if (status != EXIT_SUCCESS) std::exit(status);
+}
+
+int Lox::runScript(const std::string& fileName)
+{
+    // "-" reads the script from stdin, the tokens hold views into
+    // file so it has to stay alive until run returns
+    SourceFile file;
+    if (!file.open(fileName))
     {
-        std::cerr << "Error opening file." << std::endl;
-        std::exit(64);
+        errorOutput << "Error opening file." << std::endl;
+        return 66; // 66: input file did not exist or was not readable
+    }
+    // entries are kept under the script's path, so a script from stdin (which has none) isn't cached
+    // - the same script reached by another relative path still finds its entry
+    if (!cacheDirectory.empty() && fileName != "-")
+    {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(fileName, error);
+        if (!error)
+        {
+            cacheKey = absolute.lexically_normal().string();
+            cache.emplace(cacheDirectory);
+        }
     }
 
-    // set file stream to UTF-8 encoding mode
-    // - causes error on build???
-    // file.imbue(std::locale(file.getloc(), new std::codecvt_utf8<char>));
+    this->run(file.view());
+    printStats();
+    if (reporter.hadError()) return 65; // 65: data format error
+    if (reporter.hadRuntimeError()) return 70; // 70: internal software error
+    return EXIT_SUCCESS;
+}
+
+int Lox::runBatch(const std::vector<std::string>& paths)
+{
+    // directories are listed in name order, so a batch runs (and prints) the same way every time
+    std::vector<std::string> fileNames;
+    for (const std::string& path : paths)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(path, error))
+        {
+            fileNames.push_back(path);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path, error))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".lox") found.push_back(entry.path().string());
+        }
+        std::sort(found.begin(), found.end());
+        fileNames.insert(fileNames.end(), found.begin(), found.end());
+    }
 
-    std::string fileContents;
-    std::string line;
+    // every script's output is held until the batch is done, so scripts finishing
+    // at the same time never interleave theirs
+    struct Result
+    {
+        std::ostringstream output;
+        std::ostringstream errors;
+        int status = EXIT_SUCCESS;
+    };
+    std::vector<Result> results(fileNames.size());
 
-    while (std::getline(file, line))
+    auto begin = std::chrono::steady_clock::now();
+    WorkStealingPool pool(jobs);
+    for (std::size_t i = 0; i < fileNames.size(); i++)
     {
-        fileContents += line;
+        pool.submit([this, &fileNames, &results, i]
+        {
+            Result& result = results[i];
+            result.status = runIsolated(fileNames[i], result.output, result.errors);
+        });
     }
-    file.close();
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
 
-    return fileContents;
+    // the scripts' output in order, errors (and stats) under the name of the script they came from
+    int status = EXIT_SUCCESS;
+    int failed = 0;
+    for (std::size_t i = 0; i < fileNames.size(); i++)
+    {
+        const Result& result = results[i];
+        std::string errors = result.errors.str();
+        output << result.output.str();
+        if (result.status != EXIT_SUCCESS)
+        {
+            failed++;
+            if (status == EXIT_SUCCESS) status = result.status;
+            errorOutput << "== " << fileNames[i] << " (exit " << result.status << ")\n" << errors;
+        }
+        else if (!errors.empty())
+        {
+            errorOutput << "== " << fileNames[i] << "\n" << errors;
+        }
+    }
+    output.flush();
+
+    char summary[160];
+    std::snprintf(summary, sizeof(summary), "batch: %zu scripts, %d failed, %.3f s on %u threads, %.0f scripts/s",
+                  fileNames.size(), failed, seconds, pool.size(), seconds > 0 ? fileNames.size() / seconds : 0.0);
+    errorOutput << summary << std::endl;
+    return status;
 }
 
-void Lox::error(int line, const std::string& message)
+// a fresh interpreter with this one's settings, nothing one script of a batch does is seen by another
+int Lox::runIsolated(const std::string& fileName, std::ostream& scriptOutput, std::ostream& scriptErrors) const
 {
-    Lox::report(line, "", message);
+    Lox script(scriptOutput, scriptErrors);
+    script.mode = mode;
+    script.tokenFormat = tokenFormat;
+    script.gcStats = gcStats;
+    script.icStats = icStats;
+    script.foldStats = foldStats;
+    script.dispatchStats = dispatchStats;
+    script.gcGrowth = gcGrowth;
+    script.gcPauseMicros = gcPauseMicros;
+    script.cacheDirectory = cacheDirectory;
+    script.vm.getHeap().setPacing(gcGrowth, gcPauseMicros);
+    return script.runScript(fileName);
 }
 
-void Lox::report(int line, const std::string& where, const std::string& message)
+void Lox::printStats()
 {
-    std::cerr << "[Line " << line << "] Error " << where << ": " << message << std::endl;
-    Lox::hadError = true;
+    if (gcStats) errorOutput << vm.getHeap().stats().report();
+    if (icStats)
+    {
+        #ifdef LOX_IC_STATS
+        errorOutput << vm.icStats().report();
+        #else
+        errorOutput << "ic: not counted, build with -DLOX_IC_STATS" << std::endl;
+        #endif
+    }
+    if (dispatchStats)
+    {
+        #ifdef LOX_DISPATCH_STATS
+        errorOutput << vm.dispatchStats().report();
+        #else
+        errorOutput << "dispatch: not counted, build with -DLOX_DISPATCH_STATS" << std::endl;
+        #endif
+    }
+    if (foldStats)
+    {
+        errorOutput << "fold: " << foldedExpressions << " expressions folded, "
+                  << deadBranches << " dead branches" << std::endl;
+    }
 }
 
-bool Lox::hadError = false;
\ No newline at end of file
+void Lox::runPrompt()
+{
+    for (;;)
+    {
+        output << "> ";
+        std::string line;
+        // std::cin >> line;
+        // std::cin only reads input until it encounters whitespace (spaces, tabs, newlines)
+        // - causes hang on checking if empty for exit
+        std::getline(std::cin, line); // this reads the whole line, including whitespace
+
+        if (line.empty())
+        {
+            printStats();
+            break;
+        }
+        run(line);
+        output.flush();
+        reporter.reset();
+    }
+}
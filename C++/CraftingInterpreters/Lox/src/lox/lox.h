@@ -1,22 +1,70 @@
 #ifndef LOX_H
 #define LOX_H
+#include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "lox/error_reporter.h"
+#include "lox/scanner/token_writer.h"
+#include "lox/vm/bytecode_cache.h"
+#include "lox/vm/vm.h"
 
+// One interpreter, everything it knows is per instance (errors included), so
+// several can run at once on different threads as long as each stays on one.
 class Lox
 {
     public:
+        // the script's output and errors are written to these, which must outlive the interpreter
+        explicit Lox(std::ostream& output = std::cout, std::ostream& errorOutput = std::cerr);
+
         void run(int argc, char* argv[]);
         void runFile(std::string fileName);
         void runPrompt();
-        void run(const std::string& data);
-
-        static void error(int line, const std::string& message);
+        void run(std::string_view source);
+        // runs every script on a pool of --jobs threads, each in an interpreter of its own,
+        // a directory stands for every .lox file under it
+        // - returns the exit status of the first script that failed, in the order given
+        int runBatch(const std::vector<std::string>& paths);
 
-        static bool hadError;
+        // since the start, or since the last REPL line
+        bool hadError() const { return reporter.hadError(); }
+        bool hadRuntimeError() const { return reporter.hadRuntimeError(); }
 
     private:
-        std::string readFile(const std::string& fileName);
-        static void report(int line, const std::string& where, const std::string& message);
+        enum class Mode { RUN, TOKENS, AST, DISASSEMBLE };
+
+        [[noreturn]] void usage();
+        void dumpTokens(std::string_view source);
+        void printAst(std::string_view source);
+        void interpret(std::string_view source);
+        LoxFunction* compile(std::string_view source);
+        bool scanInParallel(std::string_view source) const;
+        void printStats();
+        int runScript(const std::string& fileName);
+        int runIsolated(const std::string& fileName, std::ostream& scriptOutput, std::ostream& scriptErrors) const;
+
+        Mode mode = Mode::RUN;
+        bool batch = false;
+        // 0 until --jobs is given, then scanning stays on one thread and a batch uses every hardware thread
+        int jobs = 0;
+        TokenWriter::Format tokenFormat = TokenWriter::Format::TEXT;
+        bool gcStats = false;
+        bool icStats = false;
+        bool foldStats = false;
+        bool dispatchStats = false;
+        int foldedExpressions = 0;
+        int deadBranches = 0;
+        double gcGrowth = 2.0;
+        int gcPauseMicros = 500;
+        std::string cacheDirectory;
+        // only for scripts run from a file, REPL lines and stdin have no path to keep an entry under
+        std::optional<BytecodeCache> cache;
+        std::string cacheKey; // the script's path, its entry in the cache is kept under it
+        std::ostream& output;
+        std::ostream& errorOutput;
+        ErrorReporter reporter;
+        // kept for the whole session so globals survive between REPL lines
+        VM vm;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,254 @@
+#ifndef AST_H
+#define AST_H
+#include <string_view>
+#include <variant>
+#include "lox/scanner/token.h"
+
+// Syntax tree built by the Parser. Every node lives in the Arena of the
+// script being compiled, so nodes are plain structs that are never deleted
+// one by one, and child lists are arrays in the same arena.
+// - nodes hold Tokens, so the tree is only valid while the source is alive
+// - each node records its type, code walking the tree switches on it and
+//   static_casts to the matching struct
+
+// a list of child nodes stored in the arena
+template <typename T>
+struct NodeList
+{
+    T* items = nullptr;
+    int count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    T& operator[](int index) const { return items[index]; }
+    int size() const { return count; }
+};
+
+// value of a literal expression, std::monostate is nil
+using LiteralValue = std::variant<std::monostate, bool, double, std::string_view>;
+
+// nil and false are falsey, as in the VM
+inline bool isTruthy(const LiteralValue& value)
+{
+    if (std::holds_alternative<std::monostate>(value)) return false;
+    if (const bool* boolean = std::get_if<bool>(&value)) return *boolean;
+    return true;
+}
+
+enum class ExprType
+{
+    ASSIGN, BINARY, CALL, GET, GROUPING, LITERAL, LOGICAL,
+    SET, SUPER, THIS, UNARY, VARIABLE
+};
+
+struct Expr
+{
+    ExprType type;
+    int line;
+
+    Expr(ExprType type, int line): type(type), line(line) {}
+};
+
+struct AssignExpr: Expr
+{
+    Token name;
+    Expr* value;
+
+    AssignExpr(Token name, Expr* value):
+        Expr(ExprType::ASSIGN, name.line), name(name), value(value) {}
+};
+
+struct BinaryExpr: Expr
+{
+    Expr* left;
+    Token op;
+    Expr* right;
+
+    BinaryExpr(Expr* left, Token op, Expr* right):
+        Expr(ExprType::BINARY, op.line), left(left), op(op), right(right) {}
+};
+
+struct CallExpr: Expr
+{
+    Expr* callee;
+    Token paren; // closing paren, its line is used for errors in the call
+    NodeList<Expr*> arguments;
+
+    CallExpr(Expr* callee, Token paren, NodeList<Expr*> arguments):
+        Expr(ExprType::CALL, paren.line), callee(callee), paren(paren), arguments(arguments) {}
+};
+
+struct GetExpr: Expr
+{
+    Expr* object;
+    Token name;
+
+    GetExpr(Expr* object, Token name):
+        Expr(ExprType::GET, name.line), object(object), name(name) {}
+};
+
+struct GroupingExpr: Expr
+{
+    Expr* expression;
+
+    GroupingExpr(Expr* expression, int line):
+        Expr(ExprType::GROUPING, line), expression(expression) {}
+};
+
+struct LiteralExpr: Expr
+{
+    LiteralValue value;
+
+    LiteralExpr(LiteralValue value, int line):
+        Expr(ExprType::LITERAL, line), value(value) {}
+};
+
+struct LogicalExpr: Expr
+{
+    Expr* left;
+    Token op;
+    Expr* right;
+
+    LogicalExpr(Expr* left, Token op, Expr* right):
+        Expr(ExprType::LOGICAL, op.line), left(left), op(op), right(right) {}
+};
+
+struct SetExpr: Expr
+{
+    Expr* object;
+    Token name;
+    Expr* value;
+
+    SetExpr(Expr* object, Token name, Expr* value):
+        Expr(ExprType::SET, name.line), object(object), name(name), value(value) {}
+};
+
+struct SuperExpr: Expr
+{
+    Token keyword;
+    Token method;
+
+    SuperExpr(Token keyword, Token method):
+        Expr(ExprType::SUPER, keyword.line), keyword(keyword), method(method) {}
+};
+
+struct ThisExpr: Expr
+{
+    Token keyword;
+
+    explicit ThisExpr(Token keyword):
+        Expr(ExprType::THIS, keyword.line), keyword(keyword) {}
+};
+
+struct UnaryExpr: Expr
+{
+    Token op;
+    Expr* right;
+
+    UnaryExpr(Token op, Expr* right):
+        Expr(ExprType::UNARY, op.line), op(op), right(right) {}
+};
+
+struct VariableExpr: Expr
+{
+    Token name;
+
+    explicit VariableExpr(Token name):
+        Expr(ExprType::VARIABLE, name.line), name(name) {}
+};
+
+enum class StmtType
+{
+    BLOCK, CLASS, EXPRESSION, FUNCTION, IF, PRINT, RETURN, VAR, WHILE
+};
+
+struct Stmt
+{
+    StmtType type;
+    int line;
+
+    Stmt(StmtType type, int line): type(type), line(line) {}
+};
+
+struct BlockStmt: Stmt
+{
+    NodeList<Stmt*> statements;
+
+    BlockStmt(NodeList<Stmt*> statements, int line):
+        Stmt(StmtType::BLOCK, line), statements(statements) {}
+};
+
+struct FunctionStmt: Stmt
+{
+    Token name;
+    NodeList<Token> params;
+    NodeList<Stmt*> body;
+
+    FunctionStmt(Token name, NodeList<Token> params, NodeList<Stmt*> body):
+        Stmt(StmtType::FUNCTION, name.line), name(name), params(params), body(body) {}
+};
+
+struct ClassStmt: Stmt
+{
+    Token name;
+    VariableExpr* superclass; // nullptr without a < clause
+    NodeList<FunctionStmt*> methods;
+
+    ClassStmt(Token name, VariableExpr* superclass, NodeList<FunctionStmt*> methods):
+        Stmt(StmtType::CLASS, name.line), name(name), superclass(superclass), methods(methods) {}
+};
+
+struct ExpressionStmt: Stmt
+{
+    Expr* expression;
+
+    explicit ExpressionStmt(Expr* expression):
+        Stmt(StmtType::EXPRESSION, expression->line), expression(expression) {}
+};
+
+struct IfStmt: Stmt
+{
+    Expr* condition;
+    Stmt* thenBranch;
+    Stmt* elseBranch; // nullptr without an else
+
+    IfStmt(Expr* condition, Stmt* thenBranch, Stmt* elseBranch, int line):
+        Stmt(StmtType::IF, line), condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
+};
+
+struct PrintStmt: Stmt
+{
+    Expr* expression;
+
+    PrintStmt(Expr* expression, int line):
+        Stmt(StmtType::PRINT, line), expression(expression) {}
+};
+
+struct ReturnStmt: Stmt
+{
+    Token keyword;
+    Expr* value; // nullptr for a bare return
+
+    ReturnStmt(Token keyword, Expr* value):
+        Stmt(StmtType::RETURN, keyword.line), keyword(keyword), value(value) {}
+};
+
+struct VarStmt: Stmt
+{
+    Token name;
+    Expr* initializer; // nullptr when there isn't one
+
+    VarStmt(Token name, Expr* initializer):
+        Stmt(StmtType::VAR, name.line), name(name), initializer(initializer) {}
+};
+
+// for loops are desugared into a while loop inside a block by the parser
+struct WhileStmt: Stmt
+{
+    Expr* condition;
+    Stmt* body;
+
+    WhileStmt(Expr* condition, Stmt* body, int line):
+        Stmt(StmtType::WHILE, line), condition(condition), body(body) {}
+};
+#endif
@@ -0,0 +1,256 @@
+#include "ast_printer.h"
+#include <cstdio>
+
+std::string AstPrinter::print(NodeList<Stmt*> statements)
+{
+    out.clear();
+    for (const Stmt* stmt : statements)
+    {
+        print(stmt);
+        out += '\n';
+    }
+    return out;
+}
+
+void AstPrinter::printBody(NodeList<Stmt*> statements)
+{
+    for (const Stmt* stmt : statements)
+    {
+        out += ' ';
+        print(stmt);
+    }
+}
+
+void AstPrinter::print(const Stmt* stmt)
+{
+    switch (stmt->type)
+    {
+        case StmtType::BLOCK:
+            out += "(block";
+            printBody(static_cast<const BlockStmt*>(stmt)->statements);
+            out += ')';
+            break;
+        case StmtType::CLASS:
+        {
+            const ClassStmt* klass = static_cast<const ClassStmt*>(stmt);
+            out += "(class ";
+            out += klass->name.lexeme;
+            if (klass->superclass)
+            {
+                out += " < ";
+                out += klass->superclass->name.lexeme;
+            }
+            for (const FunctionStmt* method : klass->methods)
+            {
+                out += ' ';
+                print(method);
+            }
+            out += ')';
+            break;
+        }
+        case StmtType::EXPRESSION:
+            out += "(; ";
+            print(static_cast<const ExpressionStmt*>(stmt)->expression);
+            out += ')';
+            break;
+        case StmtType::FUNCTION:
+        {
+            const FunctionStmt* function = static_cast<const FunctionStmt*>(stmt);
+            out += "(fun ";
+            out += function->name.lexeme;
+            out += '(';
+            for (int i = 0; i < function->params.size(); i++)
+            {
+                if (i > 0) out += ' ';
+                out += function->params[i].lexeme;
+            }
+            out += ')';
+            printBody(function->body);
+            out += ')';
+            break;
+        }
+        case StmtType::IF:
+        {
+            const IfStmt* ifStmt = static_cast<const IfStmt*>(stmt);
+            out += "(if ";
+            print(ifStmt->condition);
+            out += ' ';
+            print(ifStmt->thenBranch);
+            if (ifStmt->elseBranch)
+            {
+                out += ' ';
+                print(ifStmt->elseBranch);
+            }
+            out += ')';
+            break;
+        }
+        case StmtType::PRINT:
+            out += "(print ";
+            print(static_cast<const PrintStmt*>(stmt)->expression);
+            out += ')';
+            break;
+        case StmtType::RETURN:
+        {
+            const ReturnStmt* returnStmt = static_cast<const ReturnStmt*>(stmt);
+            out += "(return";
+            if (returnStmt->value)
+            {
+                out += ' ';
+                print(returnStmt->value);
+            }
+            out += ')';
+            break;
+        }
+        case StmtType::VAR:
+        {
+            const VarStmt* var = static_cast<const VarStmt*>(stmt);
+            out += "(var ";
+            out += var->name.lexeme;
+            if (var->initializer)
+            {
+                out += ' ';
+                print(var->initializer);
+            }
+            out += ')';
+            break;
+        }
+        case StmtType::WHILE:
+        {
+            const WhileStmt* whileStmt = static_cast<const WhileStmt*>(stmt);
+            out += "(while ";
+            print(whileStmt->condition);
+            out += ' ';
+            print(whileStmt->body);
+            out += ')';
+            break;
+        }
+    }
+}
+
+void AstPrinter::print(const Expr* expr)
+{
+    switch (expr->type)
+    {
+        case ExprType::ASSIGN:
+        {
+            const AssignExpr* assign = static_cast<const AssignExpr*>(expr);
+            out += "(= ";
+            out += assign->name.lexeme;
+            out += ' ';
+            print(assign->value);
+            out += ')';
+            break;
+        }
+        case ExprType::BINARY:
+        {
+            const BinaryExpr* binary = static_cast<const BinaryExpr*>(expr);
+            printInfix(binary->op, binary->left, binary->right);
+            break;
+        }
+        case ExprType::LOGICAL:
+        {
+            const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+            printInfix(logical->op, logical->left, logical->right);
+            break;
+        }
+        case ExprType::CALL:
+        {
+            const CallExpr* call = static_cast<const CallExpr*>(expr);
+            out += "(call ";
+            print(call->callee);
+            for (const Expr* argument : call->arguments)
+            {
+                out += ' ';
+                print(argument);
+            }
+            out += ')';
+            break;
+        }
+        case ExprType::GET:
+        {
+            const GetExpr* get = static_cast<const GetExpr*>(expr);
+            out += "(. ";
+            print(get->object);
+            out += ' ';
+            out += get->name.lexeme;
+            out += ')';
+            break;
+        }
+        case ExprType::GROUPING:
+            out += "(group ";
+            print(static_cast<const GroupingExpr*>(expr)->expression);
+            out += ')';
+            break;
+        case ExprType::LITERAL:
+            printLiteral(static_cast<const LiteralExpr*>(expr)->value);
+            break;
+        case ExprType::SET:
+        {
+            const SetExpr* set = static_cast<const SetExpr*>(expr);
+            out += "(.= ";
+            print(set->object);
+            out += ' ';
+            out += set->name.lexeme;
+            out += ' ';
+            print(set->value);
+            out += ')';
+            break;
+        }
+        case ExprType::SUPER:
+            out += "(super ";
+            out += static_cast<const SuperExpr*>(expr)->method.lexeme;
+            out += ')';
+            break;
+        case ExprType::THIS:
+            out += "this";
+            break;
+        case ExprType::UNARY:
+        {
+            const UnaryExpr* unary = static_cast<const UnaryExpr*>(expr);
+            out += '(';
+            out += unary->op.lexeme;
+            out += ' ';
+            print(unary->right);
+            out += ')';
+            break;
+        }
+        case ExprType::VARIABLE:
+            out += static_cast<const VariableExpr*>(expr)->name.lexeme;
+            break;
+    }
+}
+
+void AstPrinter::printInfix(const Token& op, const Expr* left, const Expr* right)
+{
+    out += '(';
+    out += op.lexeme;
+    out += ' ';
+    print(left);
+    out += ' ';
+    print(right);
+    out += ')';
+}
+
+void AstPrinter::printLiteral(const LiteralValue& value)
+{
+    if (std::holds_alternative<std::monostate>(value))
+    {
+        out += "nil";
+    }
+    else if (const bool* boolean = std::get_if<bool>(&value))
+    {
+        out += *boolean ? "true" : "false";
+    }
+    else if (const double* number = std::get_if<double>(&value))
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", *number);
+        out += buffer;
+    }
+    else
+    {
+        out += '"';
+        out += std::get<std::string_view>(value);
+        out += '"';
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef AST_PRINTER_H
+#define AST_PRINTER_H
+#include <string>
+#include "ast.h"
+
+// Prints a syntax tree as nested s-expressions, one statement per line,
+// for checking what the parser made of a script.
+class AstPrinter
+{
+    public:
+        std::string print(NodeList<Stmt*> statements);
+
+    private:
+        void print(const Stmt* stmt);
+        void print(const Expr* expr);
+        void printBody(NodeList<Stmt*> statements);
+        void printInfix(const Token& op, const Expr* left, const Expr* right);
+        void printLiteral(const LiteralValue& value);
+
+        std::string out;
+};
+#endif
@@ -0,0 +1,198 @@
+#include "constant_folder.h"
+#include <cstring>
+#include <string_view>
+
+static bool isLiteral(const Expr* expr)
+{
+    return expr->type == ExprType::LITERAL;
+}
+
+static const LiteralValue& literalValue(const Expr* expr)
+{
+    return static_cast<const LiteralExpr*>(expr)->value;
+}
+
+ConstantFolder::ConstantFolder(Arena& arena): arena(arena) {}
+
+void ConstantFolder::fold(NodeList<Stmt*> statements)
+{
+    body(statements);
+}
+
+void ConstantFolder::body(NodeList<Stmt*> statements)
+{
+    for (Stmt* stmt : statements) statement(stmt);
+}
+
+void ConstantFolder::statement(Stmt* stmt)
+{
+    switch (stmt->type)
+    {
+        case StmtType::BLOCK:
+            body(static_cast<BlockStmt*>(stmt)->statements);
+            break;
+        case StmtType::CLASS:
+            for (FunctionStmt* method : static_cast<ClassStmt*>(stmt)->methods) body(method->body);
+            break;
+        case StmtType::EXPRESSION:
+            expression(static_cast<ExpressionStmt*>(stmt)->expression);
+            break;
+        case StmtType::FUNCTION:
+            body(static_cast<FunctionStmt*>(stmt)->body);
+            break;
+        case StmtType::IF:
+        {
+            IfStmt* ifStmt = static_cast<IfStmt*>(stmt);
+            condition(ifStmt->condition);
+            statement(ifStmt->thenBranch);
+            if (ifStmt->elseBranch) statement(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::PRINT:
+            expression(static_cast<PrintStmt*>(stmt)->expression);
+            break;
+        case StmtType::RETURN:
+        {
+            ReturnStmt* returnStmt = static_cast<ReturnStmt*>(stmt);
+            if (returnStmt->value) expression(returnStmt->value);
+            break;
+        }
+        case StmtType::VAR:
+        {
+            VarStmt* var = static_cast<VarStmt*>(stmt);
+            if (var->initializer) expression(var->initializer);
+            break;
+        }
+        case StmtType::WHILE:
+        {
+            WhileStmt* whileStmt = static_cast<WhileStmt*>(stmt);
+            condition(whileStmt->condition);
+            statement(whileStmt->body);
+            break;
+        }
+    }
+}
+
+// an if or while condition, a literal one means a branch that never runs (or a loop that never stops testing)
+void ConstantFolder::condition(Expr*& expr)
+{
+    expression(expr);
+    if (isLiteral(expr)) branches++;
+}
+
+void ConstantFolder::expression(Expr*& expr)
+{
+    switch (expr->type)
+    {
+        case ExprType::ASSIGN:
+            expression(static_cast<AssignExpr*>(expr)->value);
+            break;
+        case ExprType::BINARY:
+            binary(expr);
+            break;
+        case ExprType::CALL:
+        {
+            CallExpr* call = static_cast<CallExpr*>(expr);
+            expression(call->callee);
+            for (Expr*& argument : call->arguments) expression(argument);
+            break;
+        }
+        case ExprType::GET:
+            expression(static_cast<GetExpr*>(expr)->object);
+            break;
+        case ExprType::GROUPING:
+        {
+            // a grouped literal is just the literal
+            Expr*& inner = static_cast<GroupingExpr*>(expr)->expression;
+            expression(inner);
+            if (isLiteral(inner)) expr = inner;
+            break;
+        }
+        case ExprType::LOGICAL:
+        {
+            // the Compiler drops whichever side a literal left operand makes dead
+            LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+            expression(logical->left);
+            expression(logical->right);
+            if (isLiteral(logical->left)) branches++;
+            break;
+        }
+        case ExprType::SET:
+        {
+            SetExpr* set = static_cast<SetExpr*>(expr);
+            expression(set->object);
+            expression(set->value);
+            break;
+        }
+        case ExprType::UNARY:
+            unary(expr);
+            break;
+        case ExprType::LITERAL:
+        case ExprType::SUPER:
+        case ExprType::THIS:
+        case ExprType::VARIABLE:
+            break;
+    }
+}
+
+void ConstantFolder::binary(Expr*& expr)
+{
+    BinaryExpr* binary = static_cast<BinaryExpr*>(expr);
+    expression(binary->left);
+    expression(binary->right);
+    if (!isLiteral(binary->left) || !isLiteral(binary->right)) return;
+
+    const LiteralValue& left = literalValue(binary->left);
+    const LiteralValue& right = literalValue(binary->right);
+    TokenType op = binary->op.type;
+
+    // same as the VM's ==: different types are unequal, numbers compare as doubles and
+    // strings by their characters, since equal strings are interned to one object
+    if (op == TokenType::EQUAL_EQUAL) return replace(expr, left == right);
+    if (op == TokenType::BANG_EQUAL) return replace(expr, left != right);
+
+    const std::string_view* a = std::get_if<std::string_view>(&left);
+    const std::string_view* b = std::get_if<std::string_view>(&right);
+    if (op == TokenType::PLUS && a && b)
+    {
+        char* chars = static_cast<char*>(arena.allocate(a->size() + b->size() + 1, 1));
+        std::memcpy(chars, a->data(), a->size());
+        std::memcpy(chars + a->size(), b->data(), b->size());
+        return replace(expr, std::string_view(chars, a->size() + b->size()));
+    }
+
+    const double* x = std::get_if<double>(&left);
+    const double* y = std::get_if<double>(&right);
+    if (x == nullptr || y == nullptr) return;
+
+    // >= and <= are compiled as the negation of < and >, which matters for NaN
+    switch (op)
+    {
+        case TokenType::PLUS: return replace(expr, *x + *y);
+        case TokenType::MINUS: return replace(expr, *x - *y);
+        case TokenType::STAR: return replace(expr, *x * *y);
+        case TokenType::SLASH: return replace(expr, *x / *y);
+        case TokenType::GREATER: return replace(expr, *x > *y);
+        case TokenType::GREATER_EQUAL: return replace(expr, !(*x < *y));
+        case TokenType::LESS: return replace(expr, *x < *y);
+        case TokenType::LESS_EQUAL: return replace(expr, !(*x > *y));
+        default: return;
+    }
+}
+
+void ConstantFolder::unary(Expr*& expr)
+{
+    UnaryExpr* unary = static_cast<UnaryExpr*>(expr);
+    expression(unary->right);
+    if (!isLiteral(unary->right)) return;
+
+    const LiteralValue& value = literalValue(unary->right);
+    if (unary->op.type == TokenType::BANG) return replace(expr, !isTruthy(value));
+    if (const double* number = std::get_if<double>(&value)) return replace(expr, -*number);
+}
+
+void ConstantFolder::replace(Expr*& expr, LiteralValue value)
+{
+    expr = arena.make<LiteralExpr>(value, expr->line);
+    expressions++;
+}
@@ -0,0 +1,40 @@
+#ifndef CONSTANT_FOLDER_H
+#define CONSTANT_FOLDER_H
+#include "ast.h"
+#include "lox/util/arena.h"
+
+// Optimisation pass between the Parser and the Compiler, rewrites the tree
+// in place so expressions made only of literals become one literal.
+// - arithmetic, comparisons, ==, string concatenation, ! and unary - are
+//   folded, exactly as the VM would work them out
+// - anything that would be a runtime error ("a" - 1) is left for the VM to
+//   report when it runs
+// - conditions that fold to a literal leave a branch that can never run,
+//   the Compiler checks those for errors but emits no code for them
+// - concatenated strings are copied into the arena, so the tree still
+//   only lives as long as the arena and the source
+class ConstantFolder
+{
+    public:
+        explicit ConstantFolder(Arena& arena);
+
+        void fold(NodeList<Stmt*> statements);
+
+        // expressions replaced by a literal and branches found dead so far
+        int foldedExpressions() const { return expressions; }
+        int deadBranches() const { return branches; }
+
+    private:
+        void statement(Stmt* stmt);
+        void body(NodeList<Stmt*> statements);
+        void condition(Expr*& expr);
+        void expression(Expr*& expr);
+        void binary(Expr*& expr);
+        void unary(Expr*& expr);
+        void replace(Expr*& expr, LiteralValue value);
+
+        Arena& arena;
+        int expressions = 0;
+        int branches = 0;
+};
+#endif
@@ -0,0 +1,517 @@
+#include "parser.h"
+
+// the bytecode addresses arguments and parameters with a single byte
+static constexpr int MAX_ARGUMENTS = 255;
+
+Parser::Parser(TokenStream& tokens, Arena& arena, ErrorReporter& reporter): tokens(tokens), arena(arena), reporter(reporter) {}
+
+NodeList<Stmt*> Parser::parse()
+{
+    std::size_t mark = statementScratch.size();
+    while (!tokens.isAtEnd())
+    {
+        Stmt* stmt = declaration();
+        if (stmt) statementScratch.push_back(stmt);
+    }
+
+    return finishList(statementScratch, mark);
+}
+
+// returns nullptr if the declaration had a syntax error
+Stmt* Parser::declaration()
+{
+    // lists the failed declaration left half built are dropped along with it
+    std::size_t statementMark = statementScratch.size();
+    std::size_t argumentMark = argumentScratch.size();
+    std::size_t parameterMark = parameterScratch.size();
+    std::size_t methodMark = methodScratch.size();
+
+    try
+    {
+        if (match(TokenType::CLASS)) return classDeclaration();
+        if (match(TokenType::FUN)) return function(false);
+        if (match(TokenType::VAR)) return varDeclaration();
+
+        return statement();
+    }
+    catch (const ParseError&)
+    {
+        statementScratch.resize(statementMark);
+        argumentScratch.resize(argumentMark);
+        parameterScratch.resize(parameterMark);
+        methodScratch.resize(methodMark);
+
+        synchronize();
+        return nullptr;
+    }
+}
+
+Stmt* Parser::classDeclaration()
+{
+    Token name = consume(TokenType::IDENTIFIER, "Expect class name.");
+
+    VariableExpr* superclass = nullptr;
+    if (match(TokenType::LESS))
+    {
+        consume(TokenType::IDENTIFIER, "Expect superclass name.");
+        superclass = arena.make<VariableExpr>(tokens.previous());
+    }
+
+    consume(TokenType::LEFT_BRACE, "Expect '{' before class body.");
+
+    std::size_t mark = methodScratch.size();
+    while (!check(TokenType::RIGHT_BRACE) && !tokens.isAtEnd())
+    {
+        methodScratch.push_back(function(true));
+    }
+
+    consume(TokenType::RIGHT_BRACE, "Expect '}' after class body.");
+    return arena.make<ClassStmt>(name, superclass, finishList(methodScratch, mark));
+}
+
+// method only changes the wording of the error messages
+FunctionStmt* Parser::function(bool method)
+{
+    Token name = consume(TokenType::IDENTIFIER, method ? "Expect method name." : "Expect function name.");
+    consume(TokenType::LEFT_PAREN, method ? "Expect '(' after method name." : "Expect '(' after function name.");
+
+    std::size_t mark = parameterScratch.size();
+    if (!check(TokenType::RIGHT_PAREN))
+    {
+        do
+        {
+            if (parameterScratch.size() - mark >= MAX_ARGUMENTS)
+            {
+                error(tokens.peek(), "Can't have more than 255 parameters.");
+            }
+            parameterScratch.push_back(consume(TokenType::IDENTIFIER, "Expect parameter name."));
+        } while (match(TokenType::COMMA));
+    }
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
+    NodeList<Token> params = finishList(parameterScratch, mark);
+
+    consume(TokenType::LEFT_BRACE, method ? "Expect '{' before method body." : "Expect '{' before function body.");
+    NodeList<Stmt*> body = block();
+    return arena.make<FunctionStmt>(name, params, body);
+}
+
+Stmt* Parser::varDeclaration()
+{
+    Token name = consume(TokenType::IDENTIFIER, "Expect variable name.");
+
+    Expr* initializer = nullptr;
+    if (match(TokenType::EQUAL)) initializer = expression();
+
+    consume(TokenType::SEMICOLON, "Expect ';' after variable declaration.");
+    return arena.make<VarStmt>(name, initializer);
+}
+
+Stmt* Parser::statement()
+{
+    if (match(TokenType::FOR)) return forStatement();
+    if (match(TokenType::IF)) return ifStatement();
+    if (match(TokenType::PRINT)) return printStatement();
+    if (match(TokenType::RETURN)) return returnStatement();
+    if (match(TokenType::WHILE)) return whileStatement();
+    if (match(TokenType::LEFT_BRACE))
+    {
+        int line = tokens.previous().line;
+        return arena.make<BlockStmt>(block(), line);
+    }
+
+    return expressionStatement();
+}
+
+// for (initializer; condition; increment) body
+// is turned into
+// { initializer; while (condition) { body; increment; } }
+Stmt* Parser::forStatement()
+{
+    int line = tokens.previous().line;
+    consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
+
+    Stmt* initializer;
+    if (match(TokenType::SEMICOLON))
+    {
+        initializer = nullptr;
+    }
+    else if (match(TokenType::VAR))
+    {
+        initializer = varDeclaration();
+    }
+    else
+    {
+        initializer = expressionStatement();
+    }
+
+    Expr* condition = nullptr;
+    if (!check(TokenType::SEMICOLON)) condition = expression();
+    consume(TokenType::SEMICOLON, "Expect ';' after loop condition.");
+
+    Expr* increment = nullptr;
+    if (!check(TokenType::RIGHT_PAREN)) increment = expression();
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after for clauses.");
+
+    Stmt* body = statement();
+
+    if (increment)
+    {
+        Stmt* statements[] = { body, arena.make<ExpressionStmt>(increment) };
+        body = arena.make<BlockStmt>(NodeList<Stmt*>{arena.copyArray(statements, 2), 2}, line);
+    }
+
+    if (!condition) condition = arena.make<LiteralExpr>(true, line);
+    body = arena.make<WhileStmt>(condition, body, line);
+
+    if (initializer)
+    {
+        Stmt* statements[] = { initializer, body };
+        body = arena.make<BlockStmt>(NodeList<Stmt*>{arena.copyArray(statements, 2), 2}, line);
+    }
+
+    return body;
+}
+
+Stmt* Parser::ifStatement()
+{
+    int line = tokens.previous().line;
+    consume(TokenType::LEFT_PAREN, "Expect '(' after 'if'.");
+    Expr* condition = expression();
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after if condition.");
+
+    Stmt* thenBranch = statement();
+    Stmt* elseBranch = nullptr;
+    if (match(TokenType::ELSE)) elseBranch = statement();
+
+    return arena.make<IfStmt>(condition, thenBranch, elseBranch, line);
+}
+
+Stmt* Parser::printStatement()
+{
+    int line = tokens.previous().line;
+    Expr* value = expression();
+    consume(TokenType::SEMICOLON, "Expect ';' after value.");
+    return arena.make<PrintStmt>(value, line);
+}
+
+Stmt* Parser::returnStatement()
+{
+    Token keyword = tokens.previous();
+    Expr* value = nullptr;
+    if (!check(TokenType::SEMICOLON)) value = expression();
+
+    consume(TokenType::SEMICOLON, "Expect ';' after return value.");
+    return arena.make<ReturnStmt>(keyword, value);
+}
+
+Stmt* Parser::whileStatement()
+{
+    int line = tokens.previous().line;
+    consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
+    Expr* condition = expression();
+    consume(TokenType::RIGHT_PAREN, "Expect ')' after condition.");
+    Stmt* body = statement();
+
+    return arena.make<WhileStmt>(condition, body, line);
+}
+
+// the opening brace has already been consumed
+NodeList<Stmt*> Parser::block()
+{
+    std::size_t mark = statementScratch.size();
+    while (!check(TokenType::RIGHT_BRACE) && !tokens.isAtEnd())
+    {
+        Stmt* stmt = declaration();
+        if (stmt) statementScratch.push_back(stmt);
+    }
+
+    consume(TokenType::RIGHT_BRACE, "Expect '}' after block.");
+    return finishList(statementScratch, mark);
+}
+
+Stmt* Parser::expressionStatement()
+{
+    Expr* expr = expression();
+    consume(TokenType::SEMICOLON, "Expect ';' after expression.");
+    return arena.make<ExpressionStmt>(expr);
+}
+
+Expr* Parser::expression()
+{
+    return assignment();
+}
+
+Expr* Parser::assignment()
+{
+    Expr* expr = orExpression();
+
+    if (match(TokenType::EQUAL))
+    {
+        Token equals = tokens.previous();
+        Expr* value = assignment();
+
+        // the left hand side was parsed as an expression, turn it into an assignment target
+        if (expr->type == ExprType::VARIABLE)
+        {
+            Token name = static_cast<VariableExpr*>(expr)->name;
+            return arena.make<AssignExpr>(name, value);
+        }
+        else if (expr->type == ExprType::GET)
+        {
+            GetExpr* get = static_cast<GetExpr*>(expr);
+            return arena.make<SetExpr>(get->object, get->name, value);
+        }
+
+        // reported but not thrown, the parser isn't confused about where it is
+        error(equals, "Invalid assignment target.");
+    }
+
+    return expr;
+}
+
+Expr* Parser::orExpression()
+{
+    Expr* expr = andExpression();
+
+    while (match(TokenType::OR))
+    {
+        Token op = tokens.previous();
+        Expr* right = andExpression();
+        expr = arena.make<LogicalExpr>(expr, op, right);
+    }
+
+    return expr;
+}
+
+Expr* Parser::andExpression()
+{
+    Expr* expr = equality();
+
+    while (match(TokenType::AND))
+    {
+        Token op = tokens.previous();
+        Expr* right = equality();
+        expr = arena.make<LogicalExpr>(expr, op, right);
+    }
+
+    return expr;
+}
+
+Expr* Parser::equality()
+{
+    Expr* expr = comparison();
+
+    while (match(TokenType::BANG_EQUAL) || match(TokenType::EQUAL_EQUAL))
+    {
+        Token op = tokens.previous();
+        Expr* right = comparison();
+        expr = arena.make<BinaryExpr>(expr, op, right);
+    }
+
+    return expr;
+}
+
+Expr* Parser::comparison()
+{
+    Expr* expr = term();
+
+    while (match(TokenType::GREATER) || match(TokenType::GREATER_EQUAL) ||
+           match(TokenType::LESS) || match(TokenType::LESS_EQUAL))
+    {
+        Token op = tokens.previous();
+        Expr* right = term();
+        expr = arena.make<BinaryExpr>(expr, op, right);
+    }
+
+    return expr;
+}
+
+Expr* Parser::term()
+{
+    Expr* expr = factor();
+
+    while (match(TokenType::MINUS) || match(TokenType::PLUS))
+    {
+        Token op = tokens.previous();
+        Expr* right = factor();
+        expr = arena.make<BinaryExpr>(expr, op, right);
+    }
+
+    return expr;
+}
+
+Expr* Parser::factor()
+{
+    Expr* expr = unary();
+
+    while (match(TokenType::SLASH) || match(TokenType::STAR))
+    {
+        Token op = tokens.previous();
+        Expr* right = unary();
+        expr = arena.make<BinaryExpr>(expr, op, right);
+    }
+
+    return expr;
+}
+
+Expr* Parser::unary()
+{
+    if (match(TokenType::BANG) || match(TokenType::MINUS))
+    {
+        Token op = tokens.previous();
+        Expr* right = unary();
+        return arena.make<UnaryExpr>(op, right);
+    }
+
+    return call();
+}
+
+Expr* Parser::call()
+{
+    Expr* expr = primary();
+
+    for (;;)
+    {
+        if (match(TokenType::LEFT_PAREN))
+        {
+            expr = finishCall(expr);
+        }
+        else if (match(TokenType::DOT))
+        {
+            Token name = consume(TokenType::IDENTIFIER, "Expect property name after '.'.");
+            expr = arena.make<GetExpr>(expr, name);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return expr;
+}
+
+Expr* Parser::finishCall(Expr* callee)
+{
+    std::size_t mark = argumentScratch.size();
+    if (!check(TokenType::RIGHT_PAREN))
+    {
+        do
+        {
+            if (argumentScratch.size() - mark >= MAX_ARGUMENTS)
+            {
+                error(tokens.peek(), "Can't have more than 255 arguments.");
+            }
+            argumentScratch.push_back(expression());
+        } while (match(TokenType::COMMA));
+    }
+
+    Token paren = consume(TokenType::RIGHT_PAREN, "Expect ')' after arguments.");
+    return arena.make<CallExpr>(callee, paren, finishList(argumentScratch, mark));
+}
+
+Expr* Parser::primary()
+{
+    int line = tokens.peek().line;
+
+    if (match(TokenType::FALSE)) return arena.make<LiteralExpr>(false, line);
+    if (match(TokenType::TRUE)) return arena.make<LiteralExpr>(true, line);
+    if (match(TokenType::NIL)) return arena.make<LiteralExpr>(std::monostate{}, line);
+
+    if (match(TokenType::NUMBER))
+    {
+        return arena.make<LiteralExpr>(std::get<double>(tokens.previous().literal), line);
+    }
+    if (match(TokenType::STRING))
+    {
+        return arena.make<LiteralExpr>(std::get<std::string_view>(tokens.previous().literal), line);
+    }
+
+    if (match(TokenType::SUPER))
+    {
+        Token keyword = tokens.previous();
+        consume(TokenType::DOT, "Expect '.' after 'super'.");
+        Token method = consume(TokenType::IDENTIFIER, "Expect superclass method name.");
+        return arena.make<SuperExpr>(keyword, method);
+    }
+
+    if (match(TokenType::THIS)) return arena.make<ThisExpr>(tokens.previous());
+    if (match(TokenType::IDENTIFIER)) return arena.make<VariableExpr>(tokens.previous());
+
+    if (match(TokenType::LEFT_PAREN))
+    {
+        Expr* expr = expression();
+        consume(TokenType::RIGHT_PAREN, "Expect ')' after expression.");
+        return arena.make<GroupingExpr>(expr, line);
+    }
+
+    throw error(tokens.peek(), "Expect expression.");
+}
+
+bool Parser::match(TokenType type)
+{
+    if (!check(type)) return false;
+
+    advance();
+    return true;
+}
+
+bool Parser::check(TokenType type)
+{
+    return tokens.peek().type == type;
+}
+
+Token Parser::advance()
+{
+    return tokens.advance();
+}
+
+Token Parser::consume(TokenType type, const char* message)
+{
+    if (check(type)) return advance();
+
+    throw error(tokens.peek(), message);
+}
+
+// reports the error and returns the exception for the caller to throw if it needs to unwind
+Parser::ParseError Parser::error(const Token& token, const char* message)
+{
+    reporter.error(token, message);
+    return ParseError{};
+}
+
+// skips tokens until what looks like the start of the next statement
+void Parser::synchronize()
+{
+    advance();
+
+    while (!tokens.isAtEnd())
+    {
+        if (tokens.previous().type == TokenType::SEMICOLON) return;
+
+        switch (tokens.peek().type)
+        {
+            case TokenType::CLASS:
+            case TokenType::FUN:
+            case TokenType::VAR:
+            case TokenType::FOR:
+            case TokenType::IF:
+            case TokenType::WHILE:
+            case TokenType::PRINT:
+            case TokenType::RETURN:
+                return;
+            default:
+                break;
+        }
+
+        advance();
+    }
+}
+
+template <typename T>
+NodeList<T> Parser::finishList(std::vector<T>& scratch, std::size_t mark)
+{
+    int count = static_cast<int>(scratch.size() - mark);
+    NodeList<T> list{arena.copyArray(scratch.data() + mark, count), count};
+    scratch.resize(mark);
+    return list;
+}
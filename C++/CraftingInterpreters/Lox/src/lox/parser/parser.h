@@ -0,0 +1,71 @@
+#ifndef PARSER_H
+#define PARSER_H
+#include <vector>
+#include "ast.h"
+#include "lox/error_reporter.h"
+#include "lox/scanner/token_stream.h"
+#include "lox/util/arena.h"
+
+// Recursive descent parser, pulls tokens from a TokenStream and builds the
+// syntax tree in the given arena.
+// - syntax errors are reported to the ErrorReporter, the parser then skips to
+//   the next statement and carries on so more than one error can be found
+class Parser
+{
+    public:
+        Parser(TokenStream& tokens, Arena& arena, ErrorReporter& reporter);
+
+        // the statements of the whole script, check the reporter's hadError before using them
+        NodeList<Stmt*> parse();
+
+    private:
+        // thrown to unwind out of a statement after reporting an error
+        struct ParseError {};
+
+        Stmt* declaration();
+        Stmt* classDeclaration();
+        FunctionStmt* function(bool method);
+        Stmt* varDeclaration();
+        Stmt* statement();
+        Stmt* forStatement();
+        Stmt* ifStatement();
+        Stmt* printStatement();
+        Stmt* returnStatement();
+        Stmt* whileStatement();
+        NodeList<Stmt*> block();
+        Stmt* expressionStatement();
+
+        Expr* expression();
+        Expr* assignment();
+        Expr* orExpression();
+        Expr* andExpression();
+        Expr* equality();
+        Expr* comparison();
+        Expr* term();
+        Expr* factor();
+        Expr* unary();
+        Expr* call();
+        Expr* finishCall(Expr* callee);
+        Expr* primary();
+
+        bool match(TokenType type);
+        bool check(TokenType type);
+        Token advance();
+        Token consume(TokenType type, const char* message);
+        ParseError error(const Token& token, const char* message);
+        void synchronize();
+
+        // lists are collected on the end of a scratch vector and copied into the arena
+        // once complete, nested lists just stack up further along the same vector
+        template <typename T>
+        NodeList<T> finishList(std::vector<T>& scratch, std::size_t mark);
+
+        TokenStream& tokens;
+        Arena& arena;
+        ErrorReporter& reporter;
+        std::vector<Stmt*> statementScratch;
+        std::vector<Expr*> argumentScratch;
+        std::vector<Token> parameterScratch;
+        std::vector<FunctionStmt*> methodScratch;
+};
+#endif
@@ -0,0 +1,214 @@
+#include "byte_scan.h"
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LOX_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOX_SIMD_SSE2
+#endif
+
+namespace
+{
+    inline bool isIdentifierByte(char c)
+    {
+        return (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') ||
+               c == '_';
+    }
+
+    inline bool isWhitespaceByte(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    inline int countTrailingZeros(std::uint32_t mask)
+    {
+        #if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+        #else
+        return __builtin_ctz(mask);
+        #endif
+    }
+
+    inline int popCount(std::uint32_t mask)
+    {
+        #if defined(_MSC_VER) && !defined(__clang__)
+        return static_cast<int>(__popcnt(mask));
+        #else
+        return __builtin_popcount(mask);
+        #endif
+    }
+
+    // lowest n bits set, n < 32
+    inline std::uint32_t bitsBelow(int n)
+    {
+        return (std::uint32_t(1) << n) - 1;
+    }
+
+#if defined(LOX_SIMD_AVX2)
+    using Vector = __m256i;
+    constexpr std::size_t VECTOR_SIZE = 32;
+    constexpr std::uint32_t ALL_LANES = 0xFFFFFFFF;
+
+    inline Vector load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    inline Vector splat(char c) { return _mm256_set1_epi8(c); }
+    inline Vector equal(Vector a, Vector b) { return _mm256_cmpeq_epi8(a, b); }
+    inline Vector either(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+    inline Vector greater(Vector a, Vector b) { return _mm256_cmpgt_epi8(a, b); }
+    inline Vector add(Vector a, Vector b) { return _mm256_add_epi8(a, b); }
+    inline std::uint32_t maskOf(Vector v) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(v)); }
+#elif defined(LOX_SIMD_SSE2)
+    using Vector = __m128i;
+    constexpr std::size_t VECTOR_SIZE = 16;
+    constexpr std::uint32_t ALL_LANES = 0xFFFF;
+
+    inline Vector load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline Vector splat(char c) { return _mm_set1_epi8(c); }
+    inline Vector equal(Vector a, Vector b) { return _mm_cmpeq_epi8(a, b); }
+    inline Vector either(Vector a, Vector b) { return _mm_or_si128(a, b); }
+    inline Vector greater(Vector a, Vector b) { return _mm_cmpgt_epi8(a, b); }
+    inline Vector add(Vector a, Vector b) { return _mm_add_epi8(a, b); }
+    inline std::uint32_t maskOf(Vector v) { return static_cast<std::uint32_t>(_mm_movemask_epi8(v)); }
+#endif
+
+#if defined(LOX_SIMD_AVX2) || defined(LOX_SIMD_SSE2)
+    // lanes with lo <= byte <= hi, there's no unsigned byte compare so the
+    // range is shifted down to start at -128 and compared as signed
+    inline Vector inRange(Vector bytes, char lo, char hi)
+    {
+        Vector shifted = add(bytes, splat(static_cast<char>(-128 - lo)));
+        return greater(splat(static_cast<char>(-128 + (hi - lo) + 1)), shifted);
+    }
+#endif
+}
+
+std::size_t findByte(const char* data, std::size_t pos, std::size_t end, char target)
+{
+    #if defined(LOX_SIMD_AVX2) || defined(LOX_SIMD_SSE2)
+    const Vector wanted = splat(target);
+    for (; pos + VECTOR_SIZE <= end; pos += VECTOR_SIZE)
+    {
+        std::uint32_t mask = maskOf(equal(load(data + pos), wanted));
+        if (mask != 0) return pos + countTrailingZeros(mask);
+    }
+    #endif
+
+    while (pos < end && data[pos] != target) pos++;
+    return pos;
+}
+
+std::size_t findAnyByte(const char* data, std::size_t pos, std::size_t end, char a, char b, char c)
+{
+    #if defined(LOX_SIMD_AVX2) || defined(LOX_SIMD_SSE2)
+    const Vector first = splat(a);
+    const Vector second = splat(b);
+    const Vector third = splat(c);
+    for (; pos + VECTOR_SIZE <= end; pos += VECTOR_SIZE)
+    {
+        Vector bytes = load(data + pos);
+        Vector hits = either(either(equal(bytes, first), equal(bytes, second)), equal(bytes, third));
+        std::uint32_t mask = maskOf(hits);
+        if (mask != 0) return pos + countTrailingZeros(mask);
+    }
+    #endif
+
+    while (pos < end && data[pos] != a && data[pos] != b && data[pos] != c) pos++;
+    return pos;
+}
+
+std::size_t findStringEnd(const char* data, std::size_t pos, std::size_t end, int& newlines)
+{
+    #if defined(LOX_SIMD_AVX2) || defined(LOX_SIMD_SSE2)
+    const Vector quote = splat('"');
+    const Vector newline = splat('\n');
+    for (; pos + VECTOR_SIZE <= end; pos += VECTOR_SIZE)
+    {
+        Vector bytes = load(data + pos);
+        std::uint32_t quotes = maskOf(equal(bytes, quote));
+        std::uint32_t lines = maskOf(equal(bytes, newline));
+        if (quotes != 0)
+        {
+            int index = countTrailingZeros(quotes);
+            newlines += popCount(lines & bitsBelow(index));
+            return pos + index;
+        }
+        newlines += popCount(lines);
+    }
+    #endif
+
+    for (; pos < end && data[pos] != '"'; pos++)
+    {
+        if (data[pos] == '\n') newlines++;
+    }
+    return pos;
+}
+
+std::size_t skipIdentifierTail(const char* data, std::size_t pos, std::size_t end)
+{
+    #if defined(LOX_SIMD_AVX2) || defined(LOX_SIMD_SSE2)
+    const Vector lowerCaseBit = splat(0x20);
+    const Vector underscore = splat('_');
+    for (; pos + VECTOR_SIZE <= end; pos += VECTOR_SIZE)
+    {
+        Vector bytes = load(data + pos);
+        // setting the 0x20 bit folds 'A'-'Z' onto 'a'-'z', no other byte lands in that range
+        Vector letters = inRange(either(bytes, lowerCaseBit), 'a', 'z');
+        Vector digits = inRange(bytes, '0', '9');
+        Vector identifier = either(either(letters, digits), equal(bytes, underscore));
+        std::uint32_t stops = ~maskOf(identifier) & ALL_LANES;
+        if (stops != 0) return pos + countTrailingZeros(stops);
+    }
+    #endif
+
+    while (pos < end && isIdentifierByte(data[pos])) pos++;
+    return pos;
+}
+
+std::size_t skipWhitespace(const char* data, std::size_t pos, std::size_t end, int& newlines)
+{
+    // most runs are a single space or a few spaces of indentation, only go wide
+    // once the run turns out to be longer than that
+    for (std::size_t limit = pos + 8; pos < end && pos < limit; pos++)
+    {
+        if (!isWhitespaceByte(data[pos])) return pos;
+        if (data[pos] == '\n') newlines++;
+    }
+
+    #if defined(LOX_SIMD_AVX2) || defined(LOX_SIMD_SSE2)
+    const Vector space = splat(' ');
+    const Vector tab = splat('\t');
+    const Vector carriageReturn = splat('\r');
+    const Vector newline = splat('\n');
+    for (; pos + VECTOR_SIZE <= end; pos += VECTOR_SIZE)
+    {
+        Vector bytes = load(data + pos);
+        Vector lines = equal(bytes, newline);
+        Vector blank = either(either(equal(bytes, space), equal(bytes, tab)),
+                              either(equal(bytes, carriageReturn), lines));
+        std::uint32_t stops = ~maskOf(blank) & ALL_LANES;
+        std::uint32_t lineMask = maskOf(lines);
+        if (stops != 0)
+        {
+            int index = countTrailingZeros(stops);
+            newlines += popCount(lineMask & bitsBelow(index));
+            return pos + index;
+        }
+        newlines += popCount(lineMask);
+    }
+    #endif
+
+    for (; pos < end && isWhitespaceByte(data[pos]); pos++)
+    {
+        if (data[pos] == '\n') newlines++;
+    }
+    return pos;
+}
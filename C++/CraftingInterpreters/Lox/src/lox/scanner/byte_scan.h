@@ -0,0 +1,27 @@
+#ifndef BYTE_SCAN_H
+#define BYTE_SCAN_H
+#include <cstddef>
+
+// Helpers the Scanner uses to skip over runs of bytes that can't end the
+// current token, 32 (AVX2) or 16 (SSE2) bytes at a time with a plain loop
+// for the tail and for targets without either instruction set.
+// - every function takes the buffer, the position to start at and the end
+//   of the buffer, and returns the position of the first byte that stops the
+//   run (end if there isn't one), never reading at or past end
+// - the ones that can cross lines add the newlines they skipped to newlines
+
+// first position holding target
+std::size_t findByte(const char* data, std::size_t pos, std::size_t end, char target);
+
+// first position holding any of a, b or c
+std::size_t findAnyByte(const char* data, std::size_t pos, std::size_t end, char a, char b, char c);
+
+// first position holding a '"', counting the newlines before it
+std::size_t findStringEnd(const char* data, std::size_t pos, std::size_t end, int& newlines);
+
+// first position that isn't a letter, digit or underscore
+std::size_t skipIdentifierTail(const char* data, std::size_t pos, std::size_t end);
+
+// first position that isn't a space, tab, carriage return or newline, counting the newlines
+std::size_t skipWhitespace(const char* data, std::size_t pos, std::size_t end, int& newlines);
+#endif
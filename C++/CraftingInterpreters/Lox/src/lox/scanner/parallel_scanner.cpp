@@ -0,0 +1,139 @@
+#include "parallel_scanner.h"
+#include "scanner.h"
+#include "byte_scan.h"
+#include <algorithm>
+
+namespace
+{
+    struct Chunk
+    {
+        std::string_view text;
+        std::vector<Token> tokens;
+        std::vector<ScanError> errors;
+    };
+}
+
+ParallelScanner::ParallelScanner(std::string_view src, ThreadPool& pool, ErrorReporter& reporter):
+    source(src), pool(pool), reporter(reporter) {}
+
+std::vector<Token> ParallelScanner::scanTokens()
+{
+    // a few chunks per thread evens out chunks that happen to be slower to scan
+    std::size_t chunkCount = std::min<std::size_t>(pool.size() * 4, source.size() / MIN_CHUNK_SIZE);
+    std::vector<std::size_t> starts = findChunkStarts(chunkCount);
+
+    std::vector<Chunk> chunks(starts.size());
+    for (std::size_t i = 0; i < starts.size(); i++)
+    {
+        std::size_t end = i + 1 < starts.size() ? starts[i + 1] : source.size();
+        chunks[i].text = source.substr(starts[i], end - starts[i]);
+    }
+
+    for (Chunk& chunk : chunks)
+    {
+        pool.submit([&chunk]
+        {
+            Scanner scanner(chunk.text, chunk.errors);
+            chunk.tokens = scanner.scanTokens();
+        });
+    }
+    pool.wait();
+
+    // every chunk ends in its own END token, only the last one is kept
+    // - a chunk's END token sits on its last line, so it started on line 1 and
+    //   spans END.line - 1 newlines that the following chunks are shifted by
+    std::vector<std::size_t> firstToken(chunks.size());
+    std::vector<int> lineOffset(chunks.size());
+    std::size_t total = 0;
+    int lines = 0;
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        firstToken[i] = total;
+        lineOffset[i] = lines;
+        total += chunks[i].tokens.size() - 1;
+        lines += chunks[i].tokens.back().line - 1;
+    }
+
+    // copying into place is as much work as the scan itself on big inputs, so it runs on the pool too
+    std::vector<Token> tokens(total + 1);
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        bool last = i + 1 == chunks.size();
+        pool.submit([&, i, last]
+        {
+            const std::vector<Token>& chunkTokens = chunks[i].tokens;
+            std::size_t count = last ? chunkTokens.size() : chunkTokens.size() - 1;
+            Token* out = tokens.data() + firstToken[i];
+            for (std::size_t t = 0; t < count; t++)
+            {
+                out[t] = chunkTokens[t];
+                out[t].line += lineOffset[i];
+            }
+            std::vector<Token>().swap(chunks[i].tokens); // free the chunk's copy early
+        });
+    }
+    pool.wait();
+
+    // errors are reported here, in source order, instead of from the worker threads
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        for (const ScanError& error : chunks[i].errors)
+        {
+            reporter.error(error.line + lineOffset[i], error.message);
+        }
+    }
+
+    return tokens;
+}
+
+// returns where each chunk starts, the first always starts at 0
+// - walks the source jumping between quotes, slashes and newlines, tracking
+//   just enough of the scanner's rules to know whether a newline is inside a
+//   string (strings can span lines) or ends a comment
+// - the source can end up with fewer chunks than asked for, down to one
+std::vector<std::size_t> ParallelScanner::findChunkStarts(std::size_t chunkCount) const
+{
+    std::vector<std::size_t> starts{0};
+    if (chunkCount < 2) return starts;
+
+    const char* data = source.data();
+    const std::size_t end = source.size();
+    const std::size_t chunkSize = end / chunkCount;
+    std::size_t nextSplit = chunkSize;
+    std::size_t pos = 0;
+    int ignoredNewlines = 0;
+
+    while (pos < end && starts.size() < chunkCount)
+    {
+        pos = findAnyByte(data, pos, end, '"', '/', '\n');
+        if (pos == end) break;
+
+        switch (data[pos])
+        {
+            case '"':
+                // an unterminated string runs to the end, so there are no more split points
+                pos = findStringEnd(data, pos + 1, end, ignoredNewlines) + 1;
+                break;
+            case '/':
+                if (pos + 1 < end && data[pos + 1] == '/')
+                {
+                    pos = findByte(data, pos + 2, end, '\n'); // the newline is a split point
+                }
+                else
+                {
+                    pos++;
+                }
+                break;
+            case '\n':
+                pos++;
+                if (pos >= nextSplit && pos < end)
+                {
+                    starts.push_back(pos);
+                    nextSplit = pos + chunkSize;
+                }
+                break;
+        }
+    }
+
+    return starts;
+}
@@ -0,0 +1,33 @@
+#ifndef PARALLEL_SCANNER_H
+#define PARALLEL_SCANNER_H
+#include <string_view>
+#include <vector>
+#include "token.h"
+#include "lox/error_reporter.h"
+#include "lox/util/thread_pool.h"
+
+// Scans a large source on several threads, producing exactly the tokens
+// (and errors, in the same order) that Scanner::scanTokens would.
+// - a quick pre-pass splits the source after newlines that aren't inside a
+//   string or a comment, so no token can straddle two chunks
+// - every chunk is scanned by its own Scanner as if it started on line 1,
+//   the lines are corrected while the chunks are stitched back together
+class ParallelScanner
+{
+    public:
+        // sources smaller than this aren't worth splitting
+        static constexpr std::size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+        // src must outlive the scanner and the tokens it produces, errors go to reporter
+        ParallelScanner(std::string_view src, ThreadPool& pool, ErrorReporter& reporter);
+
+        std::vector<Token> scanTokens();
+
+    private:
+        std::vector<std::size_t> findChunkStarts(std::size_t chunkCount) const;
+
+        std::string_view source;
+        ThreadPool& pool;
+        ErrorReporter& reporter;
+};
+#endif
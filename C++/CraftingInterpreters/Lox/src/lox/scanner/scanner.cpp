@@ -1,39 +1,41 @@
 #include "scanner.h"
 #include <iostream>
-#include "lox/types/lox_string.h"
-#include "lox/types/number.h"
+#include <charconv>
+#include "byte_scan.h"
+#include "lox/error_reporter.h"
+#include "lox/vm/heap.h"
 
-class Lox
-{
-    public:
-    static void error(int line, const std::string& message);
-};
+Scanner::Scanner(std::string_view src, ErrorReporter& reporter, Heap* strings): source(src),
+    scanned(), hasScanned(false), reporter(&reporter), errors(nullptr), strings(strings), start(0), current(0), line(1) {}
 
-Scanner::Scanner(const std::string& src): source(src), 
-    tokens(std::vector<Token>()), start(0), current(0), line(1) {}
+Scanner::Scanner(std::string_view src, std::vector<ScanError>& errors): source(src),
+    scanned(), hasScanned(false), reporter(nullptr), errors(&errors), strings(nullptr), start(0), current(0), line(1) {}
 
-std::vector<Token> Scanner::scanTokens()
+Token Scanner::nextToken()
 {
+    // whitespace and comments don't produce a token, keep going until something does
     while (!isAtEnd())
     {
         start = current;
-        scanToken();
+        if (scanToken()) return scanned;
     }
 
-    tokens.push_back(Token{TokenType::END, "", nullptr, line});
-    // each Token contains a std::unique_ptr<Object> member
-    // - std::unique_ptr isn't copyable but can be moved, due to 
-    //   this std::move needs to be used to prevent the compiler from 
-    //   trying to copy each element of the vector.
-    // - std::move enables move semantics, transferring ownership of 
-    //   the vector of tokens to the caller. This is done by transforming 
-    //   from an lvalue to an xvalue - xvalue signals to the compiler that 
-    //   it can transfer ownership of resources from one object to another 
-    //   as the current one will be destroyed soon. Or is it an rvalue reference its 
-    //   converted to, people on the web seem to give conflicting info???
-    // - from what I can tell, the vector used here is discarded but the tokens 
-    //   inside it are moved to the new vector in the caller
-    return std::move(tokens);
+    start = current;
+    return Token{TokenType::END, "", std::monostate{}, line};
+}
+
+std::vector<Token> Scanner::scanTokens()
+{
+    std::vector<Token> tokens;
+    for (;;)
+    {
+        tokens.push_back(nextToken());
+        if (tokens.back().type == TokenType::END) break;
+    }
+
+    // returning a local vector by value moves it (or elides the copy entirely),
+    // no std::move needed
+    return tokens;
 }
 
 bool Scanner::isAtEnd() const
@@ -50,8 +52,10 @@ bool Scanner::match(char expected)
     return true;
 }
 
-void Scanner::scanToken()
+// returns true if the characters consumed made up a token
+bool Scanner::scanToken()
 {
+    hasScanned = false;
     const char c = advance();
 
     switch (c)
@@ -84,7 +88,8 @@ void Scanner::scanToken()
             if (match('/'))
             {
                 // double // matched, comment to end of line, skip it all
-                while (peek() != '\n' && !isAtEnd()) advance();
+                // - the newline itself is left for the '\n' case to count
+                current = static_cast<int>(findByte(source.data(), current, source.size(), '\n'));
             }
             else
             {
@@ -94,9 +99,11 @@ void Scanner::scanToken()
         case ' ':
         case '\r':
         case '\t':
+            whitespace();
             break;
         case '\n':
             line++;
+            whitespace();
             break;
         case '"': string(); break;
         default:
@@ -111,10 +118,12 @@ void Scanner::scanToken()
             }
             else
             {
-                Lox::error(line, "Unexpected character");
+                error("Unexpected character");
             }
             break;
     }
+
+    return hasScanned;
 }
 
 char Scanner::peek() const
@@ -136,13 +145,26 @@ char Scanner::advance()
 
 void Scanner::addToken(TokenType type)
 {
-    addToken(type, nullptr);
+    addToken(type, std::monostate{});
+}
+
+void Scanner::addToken(TokenType type, Literal literal)
+{
+    std::string_view text = source.substr(start, current - start);
+    scanned = Token{type, text, literal, line};
+    hasScanned = true;
 }
 
-void Scanner::addToken(TokenType type, std::unique_ptr<Object> literal)
+void Scanner::error(const char* message)
 {
-    std::string text = source.substr(start, current - start);
-    tokens.push_back(Token{type, text, std::move(literal), line});
+    if (errors)
+    {
+        errors->push_back(ScanError{line, message});
+    }
+    else
+    {
+        reporter->error(line, message);
+    }
 }
 
 bool Scanner::isDigit(char c) const
@@ -157,49 +179,107 @@ bool Scanner::isAlpha(char c) const
            c == '_';
 }
 
-bool Scanner::isAlphaNumeric(char c) const
-{
-    return isDigit(c) || isAlpha(c);
-}
-
 void Scanner::identifier()
 {
-    while (isAlphaNumeric(peek())) advance();
+    current = static_cast<int>(skipIdentifierTail(source.data(), current, source.size()));
 
-    std::string text = source.substr(start, current - start);
-    auto typePosition = Scanner::keywords.find(text);
-    if (typePosition == Scanner::keywords.end())
+    TokenType type = identifierType();
+    if (type == TokenType::IDENTIFIER && strings)
     {
-        addToken(TokenType::IDENTIFIER);
+        addToken(type, strings->makeString(source.substr(start, current - start)));
     }
     else
     {
-        // its a keyword
-        addToken(typePosition->second);
+        addToken(type);
     }
 }
 
-void Scanner::string()
+// keywords are matched with a switch on the first (and sometimes second) character,
+// then the rest of the lexeme is compared in place, so no string or lookup table is involved
+TokenType Scanner::identifierType() const
 {
-    while (peek() != '"' && !isAtEnd())
+    switch (source[start])
     {
-        if (peek() == '\n') line++;
-        advance();
+        case 'a': return checkKeyword(1, "nd", TokenType::AND);
+        case 'c': return checkKeyword(1, "lass", TokenType::CLASS);
+        case 'e': return checkKeyword(1, "lse", TokenType::ELSE);
+        case 'f':
+            if (current - start > 1)
+            {
+                switch (source[start + 1])
+                {
+                    case 'a': return checkKeyword(2, "lse", TokenType::FALSE);
+                    case 'o': return checkKeyword(2, "r", TokenType::FOR);
+                    case 'u': return checkKeyword(2, "n", TokenType::FUN);
+                }
+            }
+            break;
+        case 'i': return checkKeyword(1, "f", TokenType::IF);
+        case 'n': return checkKeyword(1, "il", TokenType::NIL);
+        case 'o': return checkKeyword(1, "r", TokenType::OR);
+        case 'p': return checkKeyword(1, "rint", TokenType::PRINT);
+        case 'r': return checkKeyword(1, "eturn", TokenType::RETURN);
+        case 's': return checkKeyword(1, "uper", TokenType::SUPER);
+        case 't':
+            if (current - start > 1)
+            {
+                switch (source[start + 1])
+                {
+                    case 'h': return checkKeyword(2, "is", TokenType::THIS);
+                    case 'r': return checkKeyword(2, "ue", TokenType::TRUE);
+                }
+            }
+            break;
+        case 'v': return checkKeyword(1, "ar", TokenType::VAR);
+        case 'w': return checkKeyword(1, "hile", TokenType::WHILE);
+    }
+
+    return TokenType::IDENTIFIER;
+}
+
+// offset is where rest starts within the lexeme, the lengths have to match
+// exactly so that "form" or "fo" isn't taken for "for"
+TokenType Scanner::checkKeyword(int offset, std::string_view rest, TokenType type) const
+{
+    if (current - start == offset + static_cast<int>(rest.size()) &&
+        source.compare(start + offset, rest.size(), rest) == 0)
+    {
+        return type;
     }
 
+    return TokenType::IDENTIFIER;
+}
+
+// skips the rest of a run of whitespace, the first character has already been consumed
+void Scanner::whitespace()
+{
+    // a lone space between tokens is the common case, don't leave the scanner for it
+    const char next = peek();
+    if (next != ' ' && next != '\t' && next != '\r' && next != '\n') return;
+
+    int newlines = 0;
+    current = static_cast<int>(skipWhitespace(source.data(), current, source.size(), newlines));
+    line += newlines;
+}
+
+void Scanner::string()
+{
+    // jump to the closing quote, strings can span lines so count them on the way
+    int newlines = 0;
+    current = static_cast<int>(findStringEnd(source.data(), current, source.size(), newlines));
+    line += newlines;
+
     if (isAtEnd())
     {
-        Lox::error(line, "Unterminated string");
+        error("Unterminated string");
         return;
     }
 
     advance(); // consume closing "
-    // trim quotes, seems to still be including the quotes??? STRING "Hello" is printed in console
-    // - TODO: Do debug mode and inspect why
-    //   maybe its just the console showing the quotes when printing?
-    std::string value = source.substr(start + 1, current - start - 1);
-    std::unique_ptr<Object> loxString = std::make_unique<LoxString>(value);
-    addToken(TokenType::STRING, std::move(loxString)); // std::move - transfer ownership using move semantics
+    // trim quotes, the console shows STRING "Hello" because that is the lexeme,
+    // the literal skips the opening quote and stops before the closing one
+    std::string_view value = source.substr(start + 1, current - start - 2);
+    addToken(TokenType::STRING, value);
 }
 
 void Scanner::number()
@@ -214,27 +294,8 @@ void Scanner::number()
         while (isDigit(peek())) advance();
     }
 
-    double num = std::stod(source.substr(start, current - start));
-    std::unique_ptr<Object> loxNumber = std::make_unique<LoxNumber>(num);
-    addToken(TokenType::NUMBER, std::move(loxNumber)); // std::move - transfer ownership using move semantics
-}
-
-// static map of keywords
-std::map<std::string, TokenType> Scanner::keywords = {
-    {"and", TokenType::AND},
-    {"class", TokenType::CLASS},
-    {"else", TokenType::ELSE},
-    {"false", TokenType::FALSE},
-    {"for", TokenType::FOR},
-    {"fun", TokenType::FUN},
-    {"if", TokenType::IF},
-    {"nil", TokenType::NIL},
-    {"or", TokenType::OR},
-    {"print", TokenType::PRINT},
-    {"return", TokenType::RETURN},
-    {"super", TokenType::SUPER},
-    {"this", TokenType::THIS},
-    {"true", TokenType::TRUE},
-    {"var", TokenType::VAR},
-    {"while", TokenType::WHILE}
-};
\ No newline at end of file
+    // std::stod needs a std::string, from_chars parses straight out of the source buffer
+    double num = 0;
+    std::from_chars(source.data() + start, source.data() + current, num);
+    addToken(TokenType::NUMBER, num);
+}
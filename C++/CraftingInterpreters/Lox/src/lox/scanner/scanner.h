@@ -1,15 +1,36 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 #include <string>
+#include <string_view>
 #include <vector>
 #include "token.h"
-#include <map>
+
+class ErrorReporter;
+class Heap;
+
+// an error found while scanning, only collected when the Scanner is given a list to put it in
+struct ScanError
+{
+    int line;
+    std::string message;
+};
 
 class Scanner
 {
     public:
-        Scanner(const std::string& src);
+        // src is not copied, it must outlive the scanner and the tokens it produces
+        // - errors are reported to reporter straight away
+        // - identifiers are interned into strings when it's given, so the compiler
+        //   gets their LoxString without hashing them again
+        Scanner(std::string_view src, ErrorReporter& reporter, Heap* strings = nullptr);
+        // errors are appended to errors instead, for scanning on other threads
+        Scanner(std::string_view src, std::vector<ScanError>& errors);
+
+        // scans and returns one token at a time, once the source runs out
+        // every call returns an END token
+        Token nextToken();
 
+        // convenience wrapper over nextToken, scans the whole source up front
         std::vector<Token> scanTokens();
 
     private:
@@ -18,23 +39,28 @@ class Scanner
         char peekNext() const;
         bool isDigit(char c) const;
         bool isAlpha(char c) const;
-        bool isAlphaNumeric(char c) const;
 
-        void scanToken();
+        bool scanToken();
         char advance();
         bool match(char expected);
+        void whitespace();
         void string();
         void number();
         void identifier();
+        TokenType identifierType() const;
+        TokenType checkKeyword(int offset, std::string_view rest, TokenType type) const;
         void addToken(TokenType type);
-        void addToken(TokenType type, std::unique_ptr<Object> literal);
+        void addToken(TokenType type, Literal literal);
+        void error(const char* message);
 
-        std::string source;
-        std::vector<Token> tokens;
+        std::string_view source;
+        Token scanned;  // set by addToken for scanToken to hand back
+        bool hasScanned;
+        ErrorReporter* reporter;
+        std::vector<ScanError>* errors; // exactly one of these is set
+        Heap* strings;
         int start;
         int current;
         int line;
-
-        static std::map<std::string, TokenType> keywords;
 };
 #endif
\ No newline at end of file
@@ -2,5 +2,8 @@
 
 std::string Token::toString() const
 {
-    return tokenTypeToString(type) + " " + lexeme;
+    std::string text(tokenTypeToString(type));
+    text += ' ';
+    text += lexeme;
+    return text;
 }
\ No newline at end of file
@@ -1,17 +1,31 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 #include <string>
+#include <string_view>
+#include <variant>
+#include <type_traits>
 #include "token_type.h"
-#include "lox/types/object.h"
-#include <memory>
+
+class LoxString;
+
+// literal value of a NUMBER or STRING token, stored inline in the token
+// - a STRING literal is a view into the source without the quotes
+// - an IDENTIFIER holds its interned name when the scanner was given a Heap
+// - every other token type holds std::monostate
+using Literal = std::variant<std::monostate, double, std::string_view, LoxString*>;
 
 struct Token
 {
     TokenType type;
-    std::string lexeme;
-    std::unique_ptr<Object> literal;
-    const int line;
+    // view into the source buffer, whoever scanned the
+    // tokens has to keep the source alive while they are in use
+    std::string_view lexeme;
+    Literal literal;
+    int line;
 
     std::string toString() const;
 };
+
+// tokens are plain values, a std::vector<Token> can be copied and grown with memcpy
+static_assert(std::is_trivially_copyable_v<Token>);
 #endif
\ No newline at end of file
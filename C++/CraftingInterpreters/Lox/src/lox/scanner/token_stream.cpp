@@ -0,0 +1,49 @@
+#include "token_stream.h"
+#include <algorithm>
+#include <cassert>
+
+TokenStream::TokenStream(Scanner& scanner): scanner(&scanner), tokens(nullptr), ring(),
+    consumed(0), scanned(0) {}
+
+TokenStream::TokenStream(const std::vector<Token>& tokens): scanner(nullptr), tokens(&tokens), ring(),
+    consumed(0), scanned(0) {}
+
+const Token& TokenStream::peek(int distance)
+{
+    assert(distance >= 0 && distance < MAX_LOOKAHEAD);
+
+    while (scanned <= consumed + distance)
+    {
+        ring[scanned % RING_SIZE] = nextToken();
+        scanned++;
+    }
+
+    return ring[(consumed + distance) % RING_SIZE];
+}
+
+const Token& TokenStream::previous() const
+{
+    assert(consumed > 0);
+    return ring[(consumed - 1) % RING_SIZE];
+}
+
+Token TokenStream::advance()
+{
+    Token token = peek();
+    // END is sticky, the scanner keeps returning it so there's no need to stop here
+    consumed++;
+    return token;
+}
+
+bool TokenStream::isAtEnd()
+{
+    return peek().type == TokenType::END;
+}
+
+Token TokenStream::nextToken()
+{
+    if (scanner) return scanner->nextToken();
+    // END is sticky here too
+    std::size_t last = tokens->size() - 1;
+    return (*tokens)[std::min(static_cast<std::size_t>(scanned), last)];
+}
@@ -0,0 +1,40 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+#include <vector>
+#include "scanner.h"
+
+// Pulls tokens from a Scanner on demand and keeps only a small ring of
+// them, so consumers (the parser) use constant token memory however big
+// the source is. It can also replay tokens scanned up front, which is how
+// the parser reads a ParallelScanner's output.
+// - the ring holds the token just consumed plus up to MAX_LOOKAHEAD ahead of it
+// - references returned by peek and previous are only valid until the next
+//   call that scans more tokens
+class TokenStream
+{
+    public:
+        static constexpr int MAX_LOOKAHEAD = 6;
+
+        explicit TokenStream(Scanner& scanner);
+        // tokens must end in an END token and outlive the stream
+        explicit TokenStream(const std::vector<Token>& tokens);
+
+        // distance 0 is the next token to be consumed, up to MAX_LOOKAHEAD - 1
+        const Token& peek(int distance = 0);
+        // the token most recently returned by advance
+        const Token& previous() const;
+        Token advance();
+        bool isAtEnd();
+
+    private:
+        static constexpr int RING_SIZE = MAX_LOOKAHEAD + 2;
+
+        Token nextToken();
+
+        Scanner* scanner; // exactly one of these is set
+        const std::vector<Token>* tokens;
+        Token ring[RING_SIZE];
+        long long consumed; // tokens handed out by advance
+        long long scanned;  // tokens pulled from the scanner
+};
+#endif
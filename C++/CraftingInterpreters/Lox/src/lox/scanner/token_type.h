@@ -1,6 +1,6 @@
 #ifndef TOKEN_TYPE_H
 #define TOKEN_TYPE_H
-#include <string>
+#include <string_view>
 
 enum class TokenType
 {
@@ -24,5 +24,34 @@ enum class TokenType
     END
 };
 
-std::string tokenTypeToString(TokenType type);
+// indexed by TokenType, has to be kept in the same order as the enum
+inline constexpr std::string_view TOKEN_TYPE_NAMES[] = {
+    "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACE", "RIGHT_BRACE",
+    "COMMA", "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH", "STAR",
+
+    "BANG", "BANG_EQUAL",
+    "EQUAL", "EQUAL_EQUAL",
+    "GREATER", "GREATER_EQUAL",
+    "LESS", "LESS_EQUAL",
+
+    "IDENTIFIER", "STRING", "NUMBER",
+
+    "AND", "CLASS", "ELSE", "FALSE", "FUN", "FOR", "IF", "NIL", "OR",
+    "PRINT", "RETURN", "SUPER", "THIS", "TRUE", "VAR", "WHILE",
+
+    "END"
+};
+
+static_assert(sizeof(TOKEN_TYPE_NAMES) / sizeof(std::string_view) == static_cast<int>(TokenType::END) + 1,
+    "TOKEN_TYPE_NAMES is out of step with TokenType");
+
+// a lookup into a constant table, nothing is built or allocated
+constexpr std::string_view tokenTypeToString(TokenType type)
+{
+    int index = static_cast<int>(type);
+    if (index < 0 || index > static_cast<int>(TokenType::END)) return "UNKNOWN";
+    return TOKEN_TYPE_NAMES[index];
+}
+
+static_assert(tokenTypeToString(TokenType::WHILE) == "WHILE");
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "token_writer.h"
+
+TokenWriter::TokenWriter(std::ostream& out, Format format): out(out), format(format)
+{
+    buffer.reserve(BUFFER_SIZE);
+
+    if (format == Format::BINARY)
+    {
+        append("LOXT");
+        buffer.push_back(static_cast<char>(BINARY_VERSION));
+    }
+}
+
+TokenWriter::~TokenWriter()
+{
+    flush();
+}
+
+void TokenWriter::write(const Token& token)
+{
+    if (format == Format::TEXT)
+    {
+        append(tokenTypeToString(token.type));
+        buffer.push_back(' ');
+        append(token.lexeme);
+        buffer.push_back('\n');
+    }
+    else
+    {
+        buffer.push_back(static_cast<char>(token.type));
+        // lines never go backwards, so the difference is never negative
+        appendVarint(static_cast<unsigned long long>(token.line - previousLine));
+        appendVarint(token.lexeme.size());
+        append(token.lexeme);
+        previousLine = token.line;
+    }
+
+    // leave enough room that the next token (bar a huge string literal) fits without growing
+    if (buffer.size() >= BUFFER_SIZE - 4096) flush();
+}
+
+void TokenWriter::flush()
+{
+    if (buffer.empty()) return;
+
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+}
+
+void TokenWriter::append(std::string_view bytes)
+{
+    buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+void TokenWriter::appendVarint(unsigned long long value)
+{
+    // 7 bits at a time, low bits first, the top bit marks that more bytes follow
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
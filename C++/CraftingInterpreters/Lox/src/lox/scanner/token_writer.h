@@ -0,0 +1,45 @@
+#ifndef TOKEN_WRITER_H
+#define TOKEN_WRITER_H
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "token.h"
+
+// Dumps tokens into a large buffer that is only written out when it fills
+// up, instead of formatting a std::string and flushing for every token.
+//
+// TEXT writes one "TYPE lexeme" line per token, the same as Token::toString.
+//
+// BINARY is a compact format for tools that post-process token streams:
+// - header: the 4 bytes "LOXT" then a version byte (BINARY_VERSION)
+// - then per token: the TokenType as one byte, the line as an unsigned
+//   LEB128 varint holding the difference from the previous token's line
+//   (the first token is relative to line 0), the lexeme length as a varint
+//   and then the lexeme bytes. The stream ends after the END token.
+class TokenWriter
+{
+    public:
+        enum class Format { TEXT, BINARY };
+
+        static constexpr unsigned char BINARY_VERSION = 1;
+        static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+        TokenWriter(std::ostream& out, Format format);
+        ~TokenWriter();
+
+        TokenWriter(const TokenWriter&) = delete;
+        TokenWriter& operator=(const TokenWriter&) = delete;
+
+        void write(const Token& token);
+        void flush();
+
+    private:
+        void append(std::string_view bytes);
+        void appendVarint(unsigned long long value);
+
+        std::ostream& out;
+        Format format;
+        std::vector<char> buffer;
+        int previousLine = 0;
+};
+#endif
@@ -0,0 +1,122 @@
+#include "source_file.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+SourceFile::~SourceFile()
+{
+    close();
+}
+
+bool SourceFile::open(const std::string& fileName)
+{
+    close();
+
+    if (fileName == "-") return readAll(fileno(stdin), 0);
+
+    #ifdef _WIN32
+    int fd = ::_open(fileName.c_str(), _O_RDONLY | _O_BINARY);
+    #else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    #endif
+    if (fd < 0) return false;
+
+    bool ok;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+    {
+        // size is known up front, so map it or fall back to a single sized read
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        ok = map(fd, size) || readAll(fd, size);
+    }
+    else
+    {
+        // pipes, fifos and character devices, size isn't known until EOF
+        ok = readAll(fd, 0);
+    }
+
+    #ifdef _WIN32
+    ::_close(fd);
+    #else
+    ::close(fd); // a mapping stays valid after the descriptor is closed
+    #endif
+    return ok;
+}
+
+std::string_view SourceFile::view() const
+{
+    if (mapped) return std::string_view(mapped, mappedSize);
+    return buffer;
+}
+
+bool SourceFile::map(int fd, std::size_t size)
+{
+    #ifdef _WIN32
+    return false;
+    #else
+    // mmap rejects zero length mappings, an empty file reads as an empty buffer
+    if (size == 0) return false;
+
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) return false;
+
+    // the scanner walks the file front to back exactly once
+    ::madvise(address, size, MADV_SEQUENTIAL);
+
+    mapped = static_cast<const char*>(address);
+    mappedSize = size;
+    return true;
+    #endif
+}
+
+bool SourceFile::readAll(int fd, std::size_t sizeHint)
+{
+    // with a size hint the buffer is allocated once and normally filled by one read,
+    // without one (pipes, and empty files) it starts at a page and doubles until EOF
+    bool sized = sizeHint > 0;
+    buffer.resize(sized ? sizeHint : 4096);
+    std::size_t length = 0;
+
+    for (;;)
+    {
+        if (length == buffer.size())
+        {
+            if (sized) break;
+            buffer.resize(buffer.size() * 2);
+        }
+
+        #ifdef _WIN32
+        long count = ::_read(fd, &buffer[length], static_cast<unsigned int>(buffer.size() - length));
+        #else
+        ssize_t count = ::read(fd, &buffer[length], buffer.size() - length);
+        #endif
+        if (count < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (count == 0) break;
+        length += static_cast<std::size_t>(count);
+    }
+
+    buffer.resize(length);
+    return true;
+}
+
+void SourceFile::close()
+{
+    #ifndef _WIN32
+    if (mapped) ::munmap(const_cast<char*>(mapped), mappedSize);
+    #endif
+    mapped = nullptr;
+    mappedSize = 0;
+    buffer.clear();
+}
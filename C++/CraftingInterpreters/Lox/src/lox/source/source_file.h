@@ -0,0 +1,36 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+#include <string>
+#include <string_view>
+
+// Holds the full text of a script in one contiguous buffer, exactly as it
+// is on disk (newlines included), for the Scanner to take a view of.
+// - regular files are memory mapped where possible, otherwise read with
+//   a single read into a buffer sized from the file size
+// - "-", pipes and other streams are read until EOF into a growing buffer
+class SourceFile
+{
+    public:
+        SourceFile() = default;
+        ~SourceFile();
+
+        // owns the mapping, copying would unmap it twice
+        SourceFile(const SourceFile&) = delete;
+        SourceFile& operator=(const SourceFile&) = delete;
+
+        // returns false if the file couldn't be opened or read
+        bool open(const std::string& fileName);
+
+        // valid until the SourceFile is destroyed or opened again
+        std::string_view view() const;
+
+    private:
+        bool map(int fd, std::size_t size);
+        bool readAll(int fd, std::size_t sizeHint);
+        void close();
+
+        const char* mapped = nullptr;
+        std::size_t mappedSize = 0;
+        std::string buffer;
+};
+#endif
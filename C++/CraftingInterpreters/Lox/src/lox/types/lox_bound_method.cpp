@@ -0,0 +1,21 @@
+#include "lox_bound_method.h"
+#include <new>
+
+LoxBoundMethod::LoxBoundMethod(Value receiver, LoxClosure* method): Object(ObjectType::BOUND_METHOD),
+    receiver(receiver), method(method) {}
+
+std::string LoxBoundMethod::toString()
+{
+    return method->toString();
+}
+
+void LoxBoundMethod::trace(Tracer& tracer)
+{
+    tracer.visit(receiver);
+    tracer.visit(method);
+}
+
+Object* LoxBoundMethod::relocate(void* memory)
+{
+    return new (memory) LoxBoundMethod(receiver, method);
+}
@@ -0,0 +1,19 @@
+#ifndef LOX_BOUND_METHOD_H
+#define LOX_BOUND_METHOD_H
+#include "object.h"
+#include "value.h"
+#include "lox_closure.h"
+
+// a method looked up on an instance without being called straight away, remembers its receiver
+class LoxBoundMethod: public Object
+{
+    public:
+        LoxBoundMethod(Value receiver, LoxClosure* method);
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        Value receiver;
+        LoxClosure* method;
+};
+#endif
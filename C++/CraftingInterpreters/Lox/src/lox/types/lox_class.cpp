@@ -0,0 +1,27 @@
+#include "lox_class.h"
+#include <new>
+#include <utility>
+#include "shape.h"
+
+LoxClass::LoxClass(LoxString* name): Object(ObjectType::CLASS), name(name) {}
+
+std::string LoxClass::toString()
+{
+    return name->toString();
+}
+
+void LoxClass::trace(Tracer& tracer)
+{
+    tracer.visit(name);
+    methods.trace(tracer);
+    tracer.visit(rootShape);
+}
+
+Object* LoxClass::relocate(void* memory)
+{
+    LoxClass* copy = new (memory) LoxClass(name);
+    copy->methods = std::move(methods);
+    copy->rootShape = rootShape;
+    copy->instanceFields = instanceFields;
+    return copy;
+}
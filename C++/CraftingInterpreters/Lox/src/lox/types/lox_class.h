@@ -0,0 +1,28 @@
+#ifndef LOX_CLASS_H
+#define LOX_CLASS_H
+#include <cstdint>
+#include <string>
+#include "object.h"
+#include "value.h"
+#include "lox_string.h"
+#include "lox/vm/table.h"
+
+class Shape;
+
+class LoxClass: public Object
+{
+    public:
+        explicit LoxClass(LoxString* name);
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        LoxString* name;
+        // method name to LoxFunction, inherited methods are copied in by OP_INHERIT
+        Table methods;
+        // the shape of a new instance, set up by OP_CLASS
+        Shape* rootShape = nullptr;
+        // how many fields new instances have room for inline, the most any instance has had so far
+        std::uint32_t instanceFields = 0;
+};
+#endif
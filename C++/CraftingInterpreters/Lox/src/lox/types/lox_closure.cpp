@@ -0,0 +1,26 @@
+#include "lox_closure.h"
+#include <algorithm>
+#include <new>
+
+LoxClosure::LoxClosure(LoxFunction* function): Object(ObjectType::CLOSURE), function(function)
+{
+    std::fill(upvalues(), upvalues() + function->upvalueCount, nullptr);
+}
+
+std::string LoxClosure::toString()
+{
+    return function->toString();
+}
+
+void LoxClosure::trace(Tracer& tracer)
+{
+    tracer.visit(function);
+    for (int i = 0; i < function->upvalueCount; i++) tracer.visit(upvalue(i));
+}
+
+Object* LoxClosure::relocate(void* memory)
+{
+    LoxClosure* copy = new (memory) LoxClosure(function);
+    std::copy(upvalues(), upvalues() + function->upvalueCount, copy->upvalues());
+    return copy;
+}
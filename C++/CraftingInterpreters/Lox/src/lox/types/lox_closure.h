@@ -0,0 +1,37 @@
+#ifndef LOX_CLOSURE_H
+#define LOX_CLOSURE_H
+#include <cstddef>
+#include <string>
+#include "object.h"
+#include "lox_function.h"
+#include "lox_upvalue.h"
+
+// A function together with the variables it captured, which is what the VM
+// calls, the LoxFunction is just the compiled code. The upvalues are a flat
+// array stored straight after the object in the same block of memory, so a
+// closure is one allocation and reaching a captured variable takes one
+// indirection however far out it was declared. Only the Heap can create one
+// (see allocationSize).
+class LoxClosure: public Object
+{
+    public:
+        explicit LoxClosure(LoxFunction* function);
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        // unchecked, index must be below function->upvalueCount, nullptr until the VM fills it in
+        LoxUpvalue*& upvalue(int index) { return upvalues()[index]; }
+
+        // bytes needed for a closure over function
+        static std::size_t allocationSize(const LoxFunction* function)
+        {
+            return sizeof(LoxClosure) + function->upvalueCount * sizeof(LoxUpvalue*);
+        }
+
+        LoxFunction* function;
+
+    private:
+        LoxUpvalue** upvalues() { return reinterpret_cast<LoxUpvalue**>(this + 1); }
+};
+#endif
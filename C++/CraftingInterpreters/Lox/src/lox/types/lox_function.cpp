@@ -0,0 +1,30 @@
+#include "lox_function.h"
+#include <new>
+#include <utility>
+
+LoxFunction::LoxFunction(): Object(ObjectType::FUNCTION) {}
+
+std::string LoxFunction::toString()
+{
+    if (name == nullptr) return "<script>";
+    return "<fn " + name->toString() + ">";
+}
+
+void LoxFunction::trace(Tracer& tracer)
+{
+    tracer.visit(name);
+    for (Value& constant : chunk.constants) tracer.visit(constant);
+    for (InlineCache& cache : chunk.caches) cache.trace(tracer);
+}
+
+Object* LoxFunction::relocate(void* memory)
+{
+    LoxFunction* copy = new (memory) LoxFunction();
+    copy->arity = arity;
+    copy->upvalueCount = upvalueCount;
+    copy->maxSlots = maxSlots;
+    copy->isMethod = isMethod;
+    copy->chunk = std::move(chunk);
+    copy->name = name;
+    return copy;
+}
@@ -0,0 +1,26 @@
+#ifndef LOX_FUNCTION_H
+#define LOX_FUNCTION_H
+#include "object.h"
+#include "lox_string.h"
+#include "lox/vm/chunk.h"
+
+// A compiled function, the top level of a script is one too (with no name).
+// The VM only ever calls one through a LoxClosure.
+class LoxFunction: public Object
+{
+    public:
+        LoxFunction();
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        int arity = 0;
+        int upvalueCount = 0;
+        // stack slots a call can use, the callee and arguments included, so the VM can grow the stack up front
+        int maxSlots = 0;
+        // methods' closures aren't allocated young, the VM keeps pointers to them no barrier sees
+        bool isMethod = false;
+        Chunk chunk;
+        LoxString* name = nullptr;
+};
+#endif
@@ -0,0 +1,49 @@
+#include "lox_instance.h"
+#include <algorithm>
+#include <new>
+
+LoxInstance::LoxInstance(Shape* shape, std::uint32_t capacity): Object(ObjectType::INSTANCE),
+    shape(shape), capacity(capacity) {}
+
+LoxInstance::~LoxInstance()
+{
+    delete[] overflow;
+}
+
+std::string LoxInstance::toString()
+{
+    return klass()->name->toString() + " instance";
+}
+
+void LoxInstance::trace(Tracer& tracer)
+{
+    tracer.visit(shape);
+    for (std::uint32_t slot = 0; slot < shape->slotCount; slot++) tracer.visit(field(slot));
+}
+
+Object* LoxInstance::relocate(void* memory)
+{
+    LoxInstance* copy = new (memory) LoxInstance(shape, capacity);
+    std::copy(inlineFields(), inlineFields() + std::min(capacity, shape->slotCount), copy->inlineFields());
+    copy->overflow = overflow;
+    copy->overflowCapacity = overflowCapacity;
+    overflow = nullptr;
+    return copy;
+}
+
+void LoxInstance::addField(Shape* next, Value value)
+{
+    std::uint32_t slot = shape->slotCount;
+    if (slot >= capacity && slot - capacity >= overflowCapacity)
+    {
+        std::uint32_t grown = std::max(overflowCapacity * 2, 4u);
+        Value* moved = new Value[grown];
+        std::copy(overflow, overflow + overflowCapacity, moved);
+        delete[] overflow;
+        overflow = moved;
+        overflowCapacity = grown;
+    }
+
+    shape = next;
+    field(slot) = value;
+}
@@ -0,0 +1,49 @@
+#ifndef LOX_INSTANCE_H
+#define LOX_INSTANCE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "object.h"
+#include "value.h"
+#include "lox_class.h"
+#include "shape.h"
+
+// An instance's fields are a plain array of Values, its Shape says which
+// name is in which slot (and which class it's an instance of).
+// - the first capacity fields are stored straight after the object in the
+//   same block of memory, so only the Heap can create one (see
+//   allocationSize), any more go in a separately allocated overflow array
+// - the class picks capacity from how many fields its instances have had
+//   so far, so usually everything ends up inline
+class LoxInstance: public Object
+{
+    public:
+        LoxInstance(Shape* shape, std::uint32_t capacity);
+        virtual ~LoxInstance() override;
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        LoxClass* klass() const { return shape->klass; }
+        // unchecked, slot must be below shape->slotCount
+        Value& field(int slot)
+        {
+            if (static_cast<std::uint32_t>(slot) < capacity) return inlineFields()[slot];
+            return overflow[slot - capacity];
+        }
+        // moves to next, which must be a child of the current shape, and stores value in the new slot
+        void addField(Shape* next, Value value);
+
+        // bytes needed for an instance with capacity inline fields
+        static std::size_t allocationSize(std::uint32_t capacity) { return sizeof(LoxInstance) + capacity * sizeof(Value); }
+
+        Shape* shape;
+
+    private:
+        Value* inlineFields() { return reinterpret_cast<Value*>(this + 1); }
+
+        const std::uint32_t capacity;
+        std::uint32_t overflowCapacity = 0;
+        Value* overflow = nullptr;
+};
+#endif
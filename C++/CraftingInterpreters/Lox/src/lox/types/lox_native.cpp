@@ -0,0 +1,17 @@
+#include "lox_native.h"
+#include <new>
+
+LoxNative::LoxNative(NativeFn function, int arity): Object(ObjectType::NATIVE),
+    function(function), arity(arity) {}
+
+std::string LoxNative::toString()
+{
+    return "<native fn>";
+}
+
+void LoxNative::trace(Tracer&) {}
+
+Object* LoxNative::relocate(void* memory)
+{
+    return new (memory) LoxNative(function, arity);
+}
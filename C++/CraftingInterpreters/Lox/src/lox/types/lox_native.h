@@ -0,0 +1,20 @@
+#ifndef LOX_NATIVE_H
+#define LOX_NATIVE_H
+#include "object.h"
+#include "value.h"
+
+// signature of a function implemented in C++, args points at argCount values on the VM stack
+using NativeFn = Value (*)(int argCount, Value* args);
+
+class LoxNative: public Object
+{
+    public:
+        LoxNative(NativeFn function, int arity);
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        const NativeFn function;
+        const int arity;
+};
+#endif
@@ -1,8 +1,31 @@
 #include "lox_string.h"
+#include <cstring>
+#include <new>
 
-LoxString::LoxString(const std::string value): backingValue(value) {}
+LoxString::LoxString(std::uint32_t length): Object(ObjectType::STRING), length(length) {}
 
 std::string LoxString::toString()
 {
-    return backingValue;
-}
\ No newline at end of file
+    return std::string(view());
+}
+
+void LoxString::trace(Tracer&) {}
+
+Object* LoxString::relocate(void* memory)
+{
+    LoxString* copy = new (memory) LoxString(length);
+    std::memcpy(copy->chars(), chars(), length);
+    copy->hash = hash;
+    return copy;
+}
+
+std::uint32_t LoxString::hashString(std::string_view chars)
+{
+    std::uint32_t hash = 2166136261u;
+    for (char c : chars)
+    {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
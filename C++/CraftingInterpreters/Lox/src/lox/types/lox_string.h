@@ -1,15 +1,36 @@
 #ifndef LOX_STRING_H
 #define LOX_STRING_H
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include "object.h"
 
+// An immutable string. They are interned through the Heap, so two
+// LoxStrings with the same characters are always the same object and can
+// be compared by pointer.
+// - the characters are stored straight after the object in the same block
+//   of memory, so only the Heap can create one (see allocationSize)
 class LoxString: public Object
 {
     public:
-        LoxString(const std::string value);
+        explicit LoxString(std::uint32_t length);
         virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
 
-    private:
-        const std::string backingValue;
+        std::string_view view() const { return std::string_view(chars(), length); }
+        // only written while the Heap is creating the string
+        char* chars() { return reinterpret_cast<char*>(this + 1); }
+        const char* chars() const { return reinterpret_cast<const char*>(this + 1); }
+
+        // bytes needed for a string of length characters
+        static std::size_t allocationSize(std::size_t length) { return sizeof(LoxString) + length; }
+        // FNV-1a
+        static std::uint32_t hashString(std::string_view chars);
+
+        // worked out once, when the string is interned
+        std::uint32_t hash = 0;
+        const std::uint32_t length;
 };
-#endif
\ No newline at end of file
+#endif
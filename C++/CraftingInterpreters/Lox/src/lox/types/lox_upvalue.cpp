@@ -0,0 +1,24 @@
+#include "lox_upvalue.h"
+#include <new>
+
+LoxUpvalue::LoxUpvalue(Value* slot): Object(ObjectType::UPVALUE), slot(slot) {}
+
+std::string LoxUpvalue::toString()
+{
+    return "upvalue";
+}
+
+void LoxUpvalue::trace(Tracer& tracer)
+{
+    // an open upvalue's value is on the stack, which is a root anyway
+    tracer.visit(closed);
+    tracer.visit(nextOpen);
+}
+
+Object* LoxUpvalue::relocate(void* memory)
+{
+    LoxUpvalue* copy = new (memory) LoxUpvalue(slot);
+    copy->closed = closed;
+    copy->nextOpen = nextOpen;
+    return copy;
+}
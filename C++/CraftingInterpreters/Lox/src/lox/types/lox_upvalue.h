@@ -0,0 +1,28 @@
+#ifndef LOX_UPVALUE_H
+#define LOX_UPVALUE_H
+#include <string>
+#include "object.h"
+#include "value.h"
+
+// A local variable captured by a closure. While the function it belongs to
+// is running the variable stays in its stack slot and the upvalue is open,
+// pointing at it. When the slot goes away the VM closes the upvalue, moving
+// the value into it, so every closure sharing the upvalue sees the same
+// variable either way.
+class LoxUpvalue: public Object
+{
+    public:
+        explicit LoxUpvalue(Value* slot);
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        Value& value() { return slot ? *slot : closed; }
+        bool isOpen() const { return slot != nullptr; }
+
+        Value* slot; // nullptr once closed
+        Value closed;
+        // the VM's open upvalues, highest stack slot first
+        LoxUpvalue* nextOpen = nullptr;
+};
+#endif
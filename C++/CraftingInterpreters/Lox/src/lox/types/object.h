@@ -1,17 +1,68 @@
 #ifndef OBJECT_H
 #define OBJECT_H
+#include <cstdint>
 #include <string>
 
+enum class ObjectType: std::uint8_t
+{
+    STRING, FUNCTION, CLOSURE, UPVALUE, NATIVE, CLASS, INSTANCE, BOUND_METHOD, SHAPE
+};
+
+class Object;
+class Value;
+
+// Handed to Object::trace, which passes it every reference the object holds.
+// References are passed by reference so a collector that moves objects can
+// update them in place.
+class Tracer
+{
+    public:
+        virtual void visit(Object*& object) = 0;
+        virtual void visit(Value& value) = 0;
+
+        template <typename T>
+        void visit(T*& object)
+        {
+            Object* reference = object;
+            visit(reference);
+            object = static_cast<T*>(reference);
+        }
+
+    protected:
+        ~Tracer() = default;
+};
+
+// Base of every heap allocated Lox value, numbers, booleans and nil are
+// stored directly in a Value instead.
+// - objects are created and owned by the Heap, which decides where their
+//   memory comes from and frees the ones its collector can't reach
+// - type is checked instead of using dynamic_cast when the VM needs to
+//   know what an object is
 class Object
 {
     public:
         virtual std::string toString() = 0;
+        // visits every Value and Object this one references, for the collector
+        virtual void trace(Tracer& tracer) = 0;
+        // constructs a copy of this object in memory (of at least size bytes), taking over
+        // anything it owns, so the Heap can move an object out of the nursery
+        virtual Object* relocate(void* memory) = 0;
         virtual ~Object() = default;
-        Object() = default;
+        explicit Object(ObjectType type):
+            type(type), marked(false), young(false), forwarded(false), remembered(false) {}
 
         Object(const Object&) = delete;
         Object& operator=(const Object&) = delete;
         Object(Object&&) = delete;
         Object& operator=(Object&&) = delete;
+
+        const ObjectType type;
+        // the rest is only for the Heap
+        bool marked : 1;
+        bool young : 1; // still in the nursery
+        bool forwarded : 1; // moved out of the nursery, next points at the copy
+        bool remembered : 1; // old, but may reference young objects
+        std::uint32_t size = 0; // bytes of memory this object takes up
+        Object* next = nullptr;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,68 @@
+#include "shape.h"
+#include <new>
+#include <utility>
+#include "lox_class.h"
+
+Shape::Shape(LoxClass* klass): Object(ObjectType::SHAPE), klass(klass), parent(nullptr), name(nullptr), slotCount(0) {}
+
+Shape::Shape(Shape* parent, LoxString* name): Object(ObjectType::SHAPE),
+    klass(parent->klass), parent(parent), name(name), slotCount(parent->slotCount + 1)
+{
+    // a straight chain of shapes (one instance taking hundreds of fields) keeps adding to one index
+    if (parent->index && parent->index->count == parent->slotCount)
+    {
+        index = parent->index;
+        index->slots.set(name, Value::number(parent->slotCount));
+        index->count++;
+    }
+}
+
+std::string Shape::toString()
+{
+    return "<shape>";
+}
+
+void Shape::trace(Tracer& tracer)
+{
+    tracer.visit(klass);
+    tracer.visit(parent);
+    tracer.visit(name);
+    transitions.trace(tracer);
+    if (index) index->slots.trace(tracer);
+}
+
+Object* Shape::relocate(void* memory)
+{
+    Shape* copy = new (memory) Shape(klass);
+    copy->parent = parent;
+    copy->name = name;
+    copy->slotCount = slotCount;
+    copy->transitions = std::move(transitions);
+    copy->index = std::move(index);
+    return copy;
+}
+
+int Shape::find(LoxString* name)
+{
+    if (slotCount <= MAX_LINEAR_FIND)
+    {
+        for (Shape* shape = this; shape->parent; shape = shape->parent)
+        {
+            if (shape->name == name) return static_cast<int>(shape->slotCount) - 1;
+        }
+        return -1;
+    }
+
+    if (index == nullptr)
+    {
+        index = std::make_shared<Index>();
+        for (Shape* shape = this; shape->parent; shape = shape->parent)
+        {
+            index->slots.set(shape->name, Value::number(shape->slotCount - 1));
+        }
+        index->count = slotCount;
+    }
+    Value* slot = index->slots.find(name);
+    if (slot == nullptr || slot->asNumber() >= slotCount) return -1;
+    return static_cast<int>(slot->asNumber());
+}
@@ -0,0 +1,62 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "object.h"
+#include "value.h"
+#include "lox_string.h"
+#include "lox/vm/table.h"
+
+class LoxClass;
+
+// Which field of an instance is in which slot. Each class has a tree of
+// shapes rooted at the shape of a new instance with no fields, adding a
+// field moves the instance to the child shape for that name (created the
+// first time any instance of the class takes that path). So instances
+// given the same fields in the same order share one shape, which holds the
+// names once for all of them and is what inline caches key on.
+// - a shape's own name is the field it added, in its last slot
+// - shapes live as long as their class, the tree only ever grows
+class Shape: public Object
+{
+    public:
+        // the root shape for klass's instances
+        explicit Shape(LoxClass* klass);
+        // the shape after adding name to parent
+        Shape(Shape* parent, LoxString* name);
+        virtual std::string toString() override;
+        virtual void trace(Tracer& tracer) override;
+        virtual Object* relocate(void* memory) override;
+
+        // the slot holding name, -1 if this shape doesn't have it
+        int find(LoxString* name);
+        // nullptr if no instance has added name to this shape yet
+        Shape* transition(LoxString* name)
+        {
+            Value* child = transitions.find(name);
+            return child ? child->asObject<Shape>() : nullptr;
+        }
+        void addTransition(Shape* child) { transitions.set(child->name, Value::object(child)); }
+
+        LoxClass* klass;
+        Shape* parent; // nullptr for the root
+        LoxString* name; // nullptr for the root
+        std::uint32_t slotCount;
+
+    private:
+        // field name to slot, shared down a chain of shapes as long as it doesn't branch,
+        // each shape only trusts the slots below its own slotCount
+        struct Index
+        {
+            Table slots;
+            std::uint32_t count = 0;
+        };
+
+        // shapes with more fields than this use an index, built the first time they're searched
+        static constexpr std::uint32_t MAX_LINEAR_FIND = 8;
+
+        Table transitions; // field name to child shape
+        std::shared_ptr<Index> index;
+};
+#endif
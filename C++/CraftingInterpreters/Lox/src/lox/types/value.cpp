@@ -0,0 +1,14 @@
+#include "value.h"
+#include <cstdio>
+
+std::string Value::toString() const
+{
+    if (isNil()) return "nil";
+    if (isBool()) return asBool() ? "true" : "false";
+    if (isObject()) return asObject()->toString();
+
+    // %g drops the trailing zeros std::to_string would print
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", asNumber());
+    return buffer;
+}
@@ -0,0 +1,112 @@
+#ifndef VALUE_H
+#define VALUE_H
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "object.h"
+
+// A Lox value as the VM stores it: nil, a boolean and a number are held
+// directly, anything else is a pointer to an Object on the Heap.
+// - by default a Value is NaN boxed into 64 bits: any double that isn't a
+//   quiet NaN is a number, the other NaN bit patterns hold nil, the
+//   booleans and (with the sign bit set) a 48 bit object pointer
+// - define LOX_TAGGED_VALUES to build the plain tagged union instead, twice
+//   the size but every field shows up as itself in a debugger
+class Value
+{
+    public:
+        static Value nil() { return Value(); }
+
+        // unchecked, test isObjectType first
+        template <typename T>
+        T* asObject() const { return static_cast<T*>(asObject()); }
+
+        bool isObjectType(ObjectType objectType) const { return isObject() && asObject()->type == objectType; }
+
+        // how print shows the value
+        std::string toString() const;
+
+        // Lox ==, objects compare by identity, which covers strings too as they're interned
+        friend bool operator==(const Value& a, const Value& b);
+        friend bool operator!=(const Value& a, const Value& b) { return !(a == b); }
+
+#ifndef LOX_TAGGED_VALUES
+        Value(): bits(NIL_BITS) {}
+
+        static Value boolean(bool value) { return fromBits(value ? TRUE_BITS : FALSE_BITS); }
+        static Value number(double value) { std::uint64_t b; std::memcpy(&b, &value, sizeof(b)); return fromBits(b); }
+        static Value object(Object* value) { return fromBits(SIGN_BIT | QNAN | reinterpret_cast<std::uintptr_t>(value)); }
+
+        bool isNil() const { return bits == NIL_BITS; }
+        // true and false only differ in the lowest bit
+        bool isBool() const { return (bits | 1) == TRUE_BITS; }
+        bool isNumber() const { return (bits & QNAN) != QNAN; }
+        bool isObject() const { return (bits & (QNAN | SIGN_BIT)) == (QNAN | SIGN_BIT); }
+
+        bool asBool() const { return bits == TRUE_BITS; }
+        // nil and false are falsey, everything else is truthy
+        bool isFalsey() const { return bits == NIL_BITS || bits == FALSE_BITS; }
+        double asNumber() const { double d; std::memcpy(&d, &bits, sizeof(d)); return d; }
+        Object* asObject() const { return reinterpret_cast<Object*>(static_cast<std::uintptr_t>(bits & ~(SIGN_BIT | QNAN))); }
+
+    private:
+        // quiet NaN plus one more mantissa bit, so Intel's real NaN value can't collide with a tag
+        static constexpr std::uint64_t QNAN = 0x7ffc000000000000;
+        static constexpr std::uint64_t SIGN_BIT = 0x8000000000000000;
+        static constexpr std::uint64_t NIL_BITS = QNAN | 1;
+        static constexpr std::uint64_t FALSE_BITS = QNAN | 2;
+        static constexpr std::uint64_t TRUE_BITS = QNAN | 3;
+
+        static Value fromBits(std::uint64_t bits) { Value v; v.bits = bits; return v; }
+
+        std::uint64_t bits;
+#else
+        Value(): type(ValueType::NIL), as{} {}
+
+        static Value boolean(bool value) { Value v; v.type = ValueType::BOOL; v.as.boolean = value; return v; }
+        static Value number(double value) { Value v; v.type = ValueType::NUMBER; v.as.number = value; return v; }
+        static Value object(Object* value) { Value v; v.type = ValueType::OBJECT; v.as.object = value; return v; }
+
+        bool isNil() const { return type == ValueType::NIL; }
+        bool isBool() const { return type == ValueType::BOOL; }
+        bool isNumber() const { return type == ValueType::NUMBER; }
+        bool isObject() const { return type == ValueType::OBJECT; }
+
+        bool asBool() const { return as.boolean; }
+        bool isFalsey() const { return isNil() || (isBool() && !as.boolean); }
+        double asNumber() const { return as.number; }
+        Object* asObject() const { return as.object; }
+
+    private:
+        enum class ValueType { NIL, BOOL, NUMBER, OBJECT };
+
+        ValueType type;
+        union
+        {
+            bool boolean;
+            double number;
+            Object* object;
+        } as;
+#endif
+};
+
+// inline now that it never has to look inside a string
+inline bool operator==(const Value& a, const Value& b)
+{
+    // numbers compare as doubles, so NaN != NaN and 0 == -0 whatever the layout
+    if (a.isNumber() && b.isNumber()) return a.asNumber() == b.asNumber();
+
+#ifndef LOX_TAGGED_VALUES
+    // nil, the booleans and each object are single bit patterns
+    return a.bits == b.bits;
+#else
+    if (a.type != b.type) return false;
+    if (a.isObject()) return a.as.object == b.as.object;
+    return a.isNil() || a.as.boolean == b.as.boolean;
+#endif
+}
+
+#ifndef LOX_TAGGED_VALUES
+static_assert(sizeof(Value) == 8, "a NaN boxed Value should fit in one register");
+#endif
+#endif
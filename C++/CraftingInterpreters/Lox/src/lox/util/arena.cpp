@@ -0,0 +1,56 @@
+#include "arena.h"
+#include <cassert>
+#include <cstdint>
+
+Arena::~Arena()
+{
+    for (char* block : blocks) delete[] block;
+}
+
+void* Arena::allocate(std::size_t size, std::size_t alignment)
+{
+    // blocks come from new[], which is only aligned for the fundamental types
+    assert(alignment <= alignof(std::max_align_t));
+
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(cursor);
+    std::uintptr_t aligned = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    std::size_t padding = aligned - address;
+
+    if (cursor == nullptr || padding + size > static_cast<std::size_t>(limit - cursor))
+    {
+        // anything bigger than a quarter block gets a block to itself, so a big
+        // allocation doesn't waste what's left of the current one
+        if (size > BLOCK_SIZE / 4)
+        {
+            used += size;
+            return newBlock(size);
+        }
+
+        cursor = newBlock(BLOCK_SIZE);
+        limit = cursor + BLOCK_SIZE;
+        return allocate(size, alignment);
+    }
+
+    cursor += padding + size;
+    used += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+std::size_t Arena::bytesUsed() const
+{
+    return used;
+}
+
+std::size_t Arena::bytesReserved() const
+{
+    return reserved;
+}
+
+char* Arena::newBlock(std::size_t size)
+{
+    // new[] memory is aligned for any fundamental type
+    char* block = new char[size];
+    blocks.push_back(block);
+    reserved += size;
+    return block;
+}
@@ -0,0 +1,58 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator, memory is handed out from large blocks by moving a pointer
+// along and is only given back all at once when the arena is destroyed.
+// - nothing allocated here ever has its destructor run, so only trivially
+//   destructible types are allowed in
+class Arena
+{
+    public:
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        Arena() = default;
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* allocate(std::size_t size, std::size_t alignment);
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        T* copyArray(const T* items, std::size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "arena arrays are copied with memcpy");
+            if (count == 0) return nullptr;
+
+            T* copy = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            std::memcpy(copy, items, sizeof(T) * count);
+            return copy;
+        }
+
+        // bytes handed out so far, and bytes reserved from the system for them
+        std::size_t bytesUsed() const;
+        std::size_t bytesReserved() const;
+
+    private:
+        char* newBlock(std::size_t size);
+
+        std::vector<char*> blocks;
+        char* cursor = nullptr;
+        char* limit = nullptr;
+        std::size_t used = 0;
+        std::size_t reserved = 0;
+};
+#endif
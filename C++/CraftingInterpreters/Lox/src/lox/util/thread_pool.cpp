@@ -0,0 +1,65 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1; // hardware_concurrency is allowed to not know
+
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        unfinished++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    tasksFinished.wait(lock, [this] { return unfinished == 0; });
+}
+
+unsigned int ThreadPool::size() const
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+void ThreadPool::work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return; // stopping and nothing left to run
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished == 0) tasksFinished.notify_all();
+    }
+}
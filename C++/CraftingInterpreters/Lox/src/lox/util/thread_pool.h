@@ -0,0 +1,37 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks off a shared queue.
+class ThreadPool
+{
+    public:
+        // 0 means one thread per hardware thread
+        explicit ThreadPool(unsigned int threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> task);
+        // blocks until every task submitted so far has finished
+        void wait();
+        unsigned int size() const;
+
+    private:
+        void work();
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable taskAvailable;
+        std::condition_variable tasksFinished;
+        int unfinished = 0; // queued plus running
+        bool stopping = false;
+};
+#endif
@@ -0,0 +1,98 @@
+#include "work_stealing_pool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount)
+{
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1; // hardware_concurrency is allowed to not know
+
+    // every queue exists before any worker starts looking through them
+    for (unsigned int i = 0; i < threadCount; i++) queues.push_back(std::make_unique<Queue>());
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&WorkStealingPool::work, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+
+    for (std::thread& worker : workers) worker.join();
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    {
+        // queued goes up under the lock a sleeping worker checks it under, so
+        // the worker either sees the task or is already waiting to be notified
+        std::lock_guard<std::mutex> lock(mutex);
+        unfinished++;
+        Queue& queue = *queues[nextQueue];
+        nextQueue = (nextQueue + 1) % queues.size();
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queued++;
+    }
+    taskAvailable.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    tasksFinished.wait(lock, [this] { return unfinished == 0; });
+}
+
+unsigned int WorkStealingPool::size() const
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+// the newest task of the worker's own queue, otherwise the oldest of the
+// next queue along that has any
+bool WorkStealingPool::take(unsigned int self, std::function<void()>& task)
+{
+    for (unsigned int i = 0; i < queues.size(); i++)
+    {
+        Queue& queue = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+
+        if (i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::work(unsigned int self)
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        if (!take(self, task))
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) return; // stopping and nothing left to run
+            continue;
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished == 0) tasksFinished.notify_all();
+    }
+}
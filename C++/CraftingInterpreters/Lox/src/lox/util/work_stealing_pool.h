@@ -0,0 +1,54 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads with a task queue each, for many tasks of uneven length.
+// - submitted tasks are dealt round the queues, so workers mostly take
+//   from their own queue without contending with each other
+// - a worker whose queue runs dry steals from the front of the others',
+//   so a queue that happened to get the slow tasks is shared out at the end
+// Same interface as ThreadPool, which suits a few tasks of similar length.
+class WorkStealingPool
+{
+    public:
+        // 0 means one thread per hardware thread
+        explicit WorkStealingPool(unsigned int threadCount = 0);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        void submit(std::function<void()> task);
+        // blocks until every task submitted so far has finished
+        void wait();
+        unsigned int size() const;
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        bool take(unsigned int self, std::function<void()>& task);
+        void work(unsigned int self);
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<int> queued{0}; // sitting in a queue, workers sleep while it's 0
+        // submitting, sleeping, waking and waiting for everything to finish
+        std::mutex mutex;
+        unsigned int nextQueue = 0;
+        std::condition_variable taskAvailable;
+        std::condition_variable tasksFinished;
+        int unfinished = 0; // queued plus running
+        bool stopping = false;
+};
+#endif
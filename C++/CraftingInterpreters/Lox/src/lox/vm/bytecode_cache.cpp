@@ -0,0 +1,371 @@
+#include "bytecode_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "lox/source/source_file.h"
+#include "lox/types/lox_string.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    enum class ConstantTag: std::uint8_t { NUMBER, STRING, FUNCTION };
+
+    constexpr char MAGIC[4] = {'L', 'O', 'X', 'C'};
+    // magic, version byte and three words
+    constexpr std::size_t HEADER_SIZE = sizeof(MAGIC) + 1 + 3 * 8;
+
+    // for the checksum and file names, so it has to be much quicker than scanning: 8 bytes a
+    // step, rotating so the top bits of each word get mixed into the bottom of later steps
+    std::uint64_t hashBytes(std::string_view bytes)
+    {
+        constexpr std::uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+        auto step = [](std::uint64_t hash, std::uint64_t word) { return (((hash << 5) | (hash >> 59)) ^ word) * MULTIPLIER; };
+
+        std::uint64_t hash = bytes.size();
+        std::size_t i = 0;
+        for (; i + 8 <= bytes.size(); i += 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, bytes.data() + i, sizeof(word));
+            hash = step(hash, word);
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+        hash = step(hash, tail);
+        return hash ^ (hash >> 32);
+    }
+
+    // changes whenever an instruction is added, removed, renamed or resized
+    std::uint64_t interpreterFingerprint()
+    {
+        std::string table;
+        #define LOX_OPCODE_FINGERPRINT(name, operands) table += #name; table += static_cast<char>('0' + (operands));
+        LOX_OPCODES(LOX_OPCODE_FINGERPRINT)
+        #undef LOX_OPCODE_FINGERPRINT
+        return hashBytes(table);
+    }
+
+    class Writer
+    {
+        public:
+            void byte(std::uint8_t value) { out.push_back(static_cast<char>(value)); }
+            void bytes(std::string_view value) { out.append(value); }
+            void string(std::string_view value) { varint(value.size()); bytes(value); }
+
+            void varint(std::uint64_t value)
+            {
+                // 7 bits at a time, low bits first, the top bit marks that more bytes follow
+                while (value >= 0x80)
+                {
+                    byte(static_cast<std::uint8_t>((value & 0x7F) | 0x80));
+                    value >>= 7;
+                }
+                byte(static_cast<std::uint8_t>(value));
+            }
+
+            void word(std::uint64_t value)
+            {
+                for (int i = 0; i < 8; i++) byte(static_cast<std::uint8_t>(value >> (8 * i)));
+            }
+
+            std::string out;
+    };
+
+    // reads past the end or malformed varints clear ok and return zeros, so a
+    // truncated file is caught by checking ok once at the end
+    class Reader
+    {
+        public:
+            explicit Reader(std::string_view in): at(in.data()), end(in.data() + in.size()) {}
+
+            std::uint8_t byte()
+            {
+                if (at == end)
+                {
+                    ok = false;
+                    return 0;
+                }
+                return static_cast<std::uint8_t>(*at++);
+            }
+
+            std::string_view bytes(std::uint64_t count)
+            {
+                if (count > remaining())
+                {
+                    ok = false;
+                    return {};
+                }
+                std::string_view read(at, count);
+                at += count;
+                return read;
+            }
+
+            std::string_view string() { return bytes(varint()); }
+
+            std::uint64_t varint()
+            {
+                std::uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    std::uint8_t b = byte();
+                    value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+                    if ((b & 0x80) == 0) return value;
+                }
+                ok = false;
+                return 0;
+            }
+
+            // a count of things each at least a byte long, so a corrupt one can't ask for a huge allocation
+            std::uint64_t count()
+            {
+                std::uint64_t value = varint();
+                if (value > remaining())
+                {
+                    ok = false;
+                    return 0;
+                }
+                return value;
+            }
+
+            std::uint64_t word()
+            {
+                std::uint64_t value = 0;
+                for (int i = 0; i < 8; i++) value |= static_cast<std::uint64_t>(byte()) << (8 * i);
+                return value;
+            }
+
+            std::size_t remaining() const { return static_cast<std::size_t>(end - at); }
+
+            bool ok = true;
+
+        private:
+            const char* at;
+            const char* end;
+    };
+
+    // false if the function holds a constant the format has no tag for
+    bool writeFunction(Writer& out, LoxFunction* function)
+    {
+        if (function->name == nullptr)
+        {
+            out.varint(0);
+        }
+        else
+        {
+            out.varint(function->name->length + 1);
+            out.bytes(function->name->view());
+        }
+        out.varint(function->arity);
+        out.varint(function->upvalueCount);
+        out.byte(function->isMethod ? 1 : 0);
+        out.varint(function->maxSlots);
+
+        const Chunk& chunk = function->chunk;
+        out.varint(chunk.code.size());
+        out.bytes(std::string_view(reinterpret_cast<const char*>(chunk.code.data()), chunk.code.size()));
+        out.varint(chunk.lineRuns().size());
+        for (const Chunk::LineRun& run : chunk.lineRuns())
+        {
+            out.varint(run.line);
+            out.varint(run.count);
+        }
+
+        out.varint(chunk.constants.size());
+        for (Value constant : chunk.constants)
+        {
+            if (constant.isNumber())
+            {
+                std::uint64_t bits;
+                double number = constant.asNumber();
+                std::memcpy(&bits, &number, sizeof(bits));
+                out.byte(static_cast<std::uint8_t>(ConstantTag::NUMBER));
+                out.word(bits);
+            }
+            else if (constant.isObjectType(ObjectType::STRING))
+            {
+                out.byte(static_cast<std::uint8_t>(ConstantTag::STRING));
+                out.string(constant.asObject<LoxString>()->view());
+            }
+            else if (constant.isObjectType(ObjectType::FUNCTION))
+            {
+                out.byte(static_cast<std::uint8_t>(ConstantTag::FUNCTION));
+                if (!writeFunction(out, constant.asObject<LoxFunction>())) return false;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        out.varint(chunk.caches.size());
+        return true;
+    }
+
+    // nullptr if the entry is malformed, whatever was allocated before that is just garbage
+    LoxFunction* readFunction(Reader& in, Heap& heap)
+    {
+        LoxFunction* function = heap.allocate<LoxFunction>();
+        std::uint64_t nameLength = in.varint();
+        if (nameLength > 0)
+        {
+            function->name = heap.makeString(in.bytes(nameLength - 1));
+            heap.writeBarrier(function, Value::nil(), Value::object(function->name));
+        }
+        function->arity = static_cast<int>(in.varint());
+        function->upvalueCount = static_cast<int>(in.varint());
+        function->isMethod = in.byte() != 0;
+        function->maxSlots = static_cast<int>(in.varint());
+
+        Chunk& chunk = function->chunk;
+        std::string_view code = in.string();
+        chunk.code.assign(code.begin(), code.end());
+        std::uint64_t runs = in.count();
+        std::uint64_t lineBytes = 0;
+        for (std::uint64_t i = 0; i < runs; i++)
+        {
+            int line = static_cast<int>(in.varint());
+            std::uint64_t count = in.varint();
+            chunk.addLineRun(line, static_cast<int>(count));
+            lineBytes += count;
+        }
+        if (lineBytes != code.size()) return nullptr;
+
+        std::uint64_t constants = in.count();
+        chunk.constants.reserve(constants);
+        for (std::uint64_t i = 0; i < constants && in.ok; i++)
+        {
+            Value constant;
+            switch (static_cast<ConstantTag>(in.byte()))
+            {
+                case ConstantTag::NUMBER:
+                {
+                    std::uint64_t bits = in.word();
+                    double number;
+                    std::memcpy(&number, &bits, sizeof(number));
+                    constant = Value::number(number);
+                    break;
+                }
+                case ConstantTag::STRING:
+                    constant = Value::object(heap.makeString(in.string()));
+                    break;
+                case ConstantTag::FUNCTION:
+                {
+                    LoxFunction* inner = readFunction(in, heap);
+                    if (inner == nullptr) return nullptr;
+                    constant = Value::object(inner);
+                    break;
+                }
+                default:
+                    return nullptr;
+            }
+            // an interned string can still be in the nursery, the same as when compiling
+            heap.writeBarrier(function, Value::nil(), constant);
+            chunk.addConstant(constant);
+        }
+
+        std::uint64_t caches = in.count();
+        for (std::uint64_t i = 0; i < caches; i++) chunk.addCache();
+        return in.ok ? function : nullptr;
+    }
+}
+
+BytecodeCache::BytecodeCache(std::string directory): directory(std::move(directory)) {}
+
+LoxFunction* BytecodeCache::load(std::string_view script, std::string_view source, Heap& heap, Globals& globals) const
+{
+    SourceFile file;
+    if (!file.open(path(script))) return nullptr;
+
+    std::string_view entry = file.view();
+    if (entry.size() < HEADER_SIZE || entry.substr(0, sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC)))
+    {
+        return nullptr;
+    }
+
+    Reader header(entry.substr(sizeof(MAGIC), HEADER_SIZE - sizeof(MAGIC)));
+    if (header.byte() != FORMAT_VERSION || header.word() != interpreterFingerprint()) return nullptr;
+    if (header.word() != source.size() || entry.size() - HEADER_SIZE < source.size()) return nullptr;
+    if (entry.substr(HEADER_SIZE, source.size()) != source) return nullptr;
+    std::string_view body = entry.substr(HEADER_SIZE + source.size());
+    if (header.word() != hashBytes(body)) return nullptr;
+
+    // the names are checked and the function read before any global is added, an entry
+    // that turns out to be bad leaves the VM's globals as they were
+    Reader in(body);
+    std::uint64_t globalCount = in.count();
+    std::vector<std::string_view> names;
+    std::unordered_set<std::string_view> seen;
+    for (std::uint64_t slot = 0; slot < globalCount && in.ok; slot++)
+    {
+        std::string_view name = in.string();
+        if (!seen.insert(name).second) return nullptr;
+        if (slot < static_cast<std::uint64_t>(globals.count()) && globals.name(static_cast<int>(slot))->view() != name)
+        {
+            return nullptr;
+        }
+        names.push_back(name);
+    }
+
+    LoxFunction* compiled = in.ok ? readFunction(in, heap) : nullptr;
+    if (compiled == nullptr || in.remaining() != 0) return nullptr;
+
+    for (std::size_t slot = globals.count(); slot < names.size(); slot++) globals.resolve(heap.makeString(names[slot]));
+    return compiled;
+}
+
+void BytecodeCache::store(std::string_view script, std::string_view source, LoxFunction* compiled, const Globals& globals) const
+{
+    Writer body;
+    body.varint(globals.count());
+    for (int slot = 0; slot < globals.count(); slot++) body.string(globals.name(slot)->view());
+    if (!writeFunction(body, compiled)) return;
+
+    Writer header;
+    header.bytes(std::string_view(MAGIC, sizeof(MAGIC)));
+    header.byte(FORMAT_VERSION);
+    header.word(interpreterFingerprint());
+    header.word(source.size());
+    header.word(hashBytes(body.out));
+
+    // written under a name of its own and renamed into place, so a run
+    // starting meanwhile never maps half an entry
+    // - the name has the thread in it too, a batch stores from several at once
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string finalPath = path(script);
+    std::size_t thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    std::string tempPath = finalPath + "." + std::to_string(getpid()) + "." + std::to_string(thread) + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(header.out.data(), static_cast<std::streamsize>(header.out.size()));
+        out.write(source.data(), static_cast<std::streamsize>(source.size()));
+        out.write(body.out.data(), static_cast<std::streamsize>(body.out.size()));
+        if (!out)
+        {
+            out.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, finalPath, error);
+    if (error) std::remove(tempPath.c_str());
+}
+
+std::string BytecodeCache::path(std::string_view script) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.loxc", static_cast<unsigned long long>(hashBytes(script)));
+    return (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,50 @@
+#ifndef BYTECODE_CACHE_H
+#define BYTECODE_CACHE_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "globals.h"
+#include "heap.h"
+#include "lox/types/lox_function.h"
+
+// Compiled scripts kept on disk, so running an unchanged script again skips
+// scanning, parsing and compiling it. Each script has one entry, named after
+// a hash of its path, which holds the source it was compiled from and
+// records the interpreter that compiled it. Anything that doesn't match
+// exactly is ignored, and overwritten once the script has been compiled
+// again, so an edited script replaces its entry rather than adding one.
+//
+// The file format, integers are unsigned LEB128 varints unless noted:
+// - header: "LOXC", FORMAT_VERSION as one byte, then 8 byte little endian
+//   words: the interpreter's fingerprint (a hash of LOX_OPCODES), the
+//   source's length, and a checksum of everything after the source
+// - the source itself, compared byte for byte, a hash match isn't enough to
+//   run what's in the entry
+// - the names of the VM's globals in slot order, code has the slots baked
+//   in so it's only loaded into a VM whose slots agree
+// - the script function: name length + 1 (0 for none) and characters,
+//   arity, upvalue count, a method flag byte, max slots, the code, its line
+//   runs as line and count pairs, constants and the number of inline caches
+// - a constant is a tag byte then a number's 8 byte word, a string's length
+//   and characters, or a whole function
+// Bump FORMAT_VERSION when an instruction changes what it does without its
+// name or size changing, the fingerprint only catches those.
+class BytecodeCache
+{
+    public:
+        static constexpr unsigned char FORMAT_VERSION = 2;
+
+        explicit BytecodeCache(std::string directory);
+
+        // nullptr if script's entry wasn't compiled from source, collection has to be paused
+        // - globals are only added to once the whole entry has been read
+        LoxFunction* load(std::string_view script, std::string_view source, Heap& heap, Globals& globals) const;
+        // best effort, an entry that can't be written just means compiling again next time
+        void store(std::string_view script, std::string_view source, LoxFunction* compiled, const Globals& globals) const;
+
+    private:
+        std::string path(std::string_view script) const;
+
+        std::string directory;
+};
+#endif
@@ -0,0 +1,115 @@
+#include "chunk.h"
+#include "lox/types/lox_function.h"
+
+static const char* const OPCODE_NAMES[] = {
+    #define LOX_OPCODE_NAME(name, operands) "OP_" #name,
+    LOX_OPCODES(LOX_OPCODE_NAME)
+    #undef LOX_OPCODE_NAME
+};
+
+static const int INSTRUCTION_LENGTHS[] = {
+    #define LOX_OPCODE_LENGTH(name, operands) 1 + (operands),
+    LOX_OPCODES(LOX_OPCODE_LENGTH)
+    #undef LOX_OPCODE_LENGTH
+};
+
+const char* opcodeName(OpCode op)
+{
+    return OPCODE_NAMES[static_cast<int>(op)];
+}
+
+int instructionLength(OpCode op)
+{
+    return INSTRUCTION_LENGTHS[static_cast<int>(op)];
+}
+
+void Chunk::write(std::uint8_t byte, int line)
+{
+    code.push_back(byte);
+    addLineRun(line, 1);
+}
+
+void Chunk::addLineRun(int line, int count)
+{
+    if (!lines.empty() && lines.back().line == line)
+    {
+        lines.back().count += count;
+    }
+    else
+    {
+        lines.push_back(LineRun{line, count});
+    }
+}
+
+void Chunk::write(OpCode op, int line)
+{
+    write(static_cast<std::uint8_t>(op), line);
+}
+
+int Chunk::addConstant(Value value)
+{
+    constants.push_back(value);
+    return static_cast<int>(constants.size()) - 1;
+}
+
+int Chunk::addCache()
+{
+    caches.emplace_back();
+    return static_cast<int>(caches.size()) - 1;
+}
+
+int Chunk::instructionLength(int offset) const
+{
+    OpCode op = static_cast<OpCode>(code[offset]);
+    int length = ::instructionLength(op);
+    if (op == OpCode::CLOSURE)
+    {
+        const Value& function = constants[(code[offset + 1] << 8) | code[offset + 2]];
+        length += 2 * function.asObject<LoxFunction>()->upvalueCount;
+    }
+    return length;
+}
+
+void Chunk::truncate(int offset, int constantCount, int cacheCount)
+{
+    constants.resize(constantCount);
+    caches.resize(cacheCount);
+
+    int excess = static_cast<int>(code.size()) - offset;
+    code.resize(offset);
+
+    while (excess > 0)
+    {
+        LineRun& run = lines.back();
+        int dropped = excess < run.count ? excess : run.count;
+        run.count -= dropped;
+        excess -= dropped;
+        if (run.count == 0) lines.pop_back();
+    }
+}
+
+void Chunk::replaceCode(const std::vector<std::uint8_t>& newCode, const std::vector<int>& newLines)
+{
+    code.clear();
+    lines.clear();
+    for (std::size_t i = 0; i < newCode.size(); i++) write(newCode[i], newLines[i]);
+}
+
+std::vector<int> Chunk::expandLines() const
+{
+    std::vector<int> expanded;
+    expanded.reserve(code.size());
+    for (const LineRun& run : lines) expanded.insert(expanded.end(), run.count, run.line);
+    return expanded;
+}
+
+int Chunk::getLine(int offset) const
+{
+    // only needed for error messages and disassembly, so a linear walk is fine
+    for (const LineRun& run : lines)
+    {
+        if (offset < run.count) return run.line;
+        offset -= run.count;
+    }
+    return lines.empty() ? 0 : lines.back().line;
+}
@@ -0,0 +1,124 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+#include <cstdint>
+#include <vector>
+#include "inline_cache.h"
+#include "lox/types/value.h"
+
+// Every instruction with the size of its operands in bytes, the list is
+// expanded into the OpCode enum and into the VM's dispatch table so the two
+// can't drift apart.
+// - constant, property and method name operands are 16 bit indexes into
+//   the chunk's constant pool, global operands are 16 bit Globals slots
+// - jump operands are 16 bit offsets, local slots and argument counts are
+//   a single byte
+// - cache operands are 16 bit indexes into the chunk's inline caches
+// - the superinstructions at the end are never emitted by the compiler,
+//   the peephole pass fuses them from the sequences their names list
+#define LOX_OPCODES(X) \
+    X(CONSTANT, 2)       /* index16: push constants[index] */ \
+    X(NIL, 0)            \
+    X(TRUE, 0)           \
+    X(FALSE, 0)          \
+    X(POP, 0)            \
+    X(GET_LOCAL, 1)      /* slot8 */ \
+    X(SET_LOCAL, 1)      /* slot8 */ \
+    X(GET_GLOBAL, 2)     /* global16 */ \
+    X(DEFINE_GLOBAL, 2)  /* global16 */ \
+    X(SET_GLOBAL, 2)     /* global16 */ \
+    X(GET_UPVALUE, 1)    /* index8 */ \
+    X(SET_UPVALUE, 1)    /* index8 */ \
+    X(GET_PROPERTY, 4)   /* name16 cache16 */ \
+    X(SET_PROPERTY, 4)   /* name16 cache16 */ \
+    X(GET_SUPER, 2)      /* name16: [this, superclass] -> bound method */ \
+    X(EQUAL, 0)          \
+    X(GREATER, 0)        \
+    X(LESS, 0)           \
+    X(ADD, 0)            \
+    X(SUBTRACT, 0)       \
+    X(MULTIPLY, 0)       \
+    X(DIVIDE, 0)         \
+    X(NOT, 0)            \
+    X(NEGATE, 0)         \
+    X(PRINT, 0)          \
+    X(JUMP, 2)           /* offset16 forwards */ \
+    X(JUMP_IF_FALSE, 2)  /* offset16 forwards, leaves the condition on the stack */ \
+    X(LOOP, 2)           /* offset16 backwards */ \
+    X(CALL, 1)           /* argc8 */ \
+    X(INVOKE, 5)         /* name16 argc8 cache16: receiver.name(args) without a bound method */ \
+    X(SUPER_INVOKE, 3)   /* name16 argc8: [this, args..., superclass] */ \
+    X(TAIL_CALL, 1)      /* argc8: CALL that replaces the caller's frame, always followed by RETURN */ \
+    X(TAIL_INVOKE, 5)    /* name16 argc8 cache16: INVOKE that replaces the caller's frame */ \
+    X(CLOSURE, 2)        /* function16, then local8 index8 for each upvalue */ \
+    X(CLOSE_UPVALUE, 0)  /* pops the top slot, closing any upvalue pointing at it */ \
+    X(RETURN, 0)         \
+    X(CLASS, 2)          /* name16 */ \
+    X(INHERIT, 0)        /* [superclass, subclass] -> [superclass], copies the methods down */ \
+    X(METHOD, 2)         /* name16: [class, function] -> [class] */ \
+    X(GET_LOCAL_CONSTANT, 3)       /* slot8 index16 */ \
+    X(ADD_LOCAL_CONSTANT, 3)       /* slot8 index16: GET_LOCAL, CONSTANT, ADD */ \
+    X(SUBTRACT_LOCAL_CONSTANT, 3)  /* slot8 index16: GET_LOCAL, CONSTANT, SUBTRACT */ \
+    X(GET_LOCAL_PROPERTY, 5)       /* slot8 name16 cache16: GET_LOCAL, GET_PROPERTY */ \
+    X(SET_LOCAL_POP, 1)            /* slot8 */ \
+    X(JUMP_IF_FALSE_POP, 2)        /* offset16: pops the condition either way */ \
+    X(LESS_JUMP_IF_FALSE, 2)       /* offset16: LESS, JUMP_IF_FALSE_POP */
+
+enum class OpCode: std::uint8_t
+{
+    #define LOX_OPCODE_ENUM(name, operands) name,
+    LOX_OPCODES(LOX_OPCODE_ENUM)
+    #undef LOX_OPCODE_ENUM
+};
+
+constexpr int OPCODE_COUNT = 0
+    #define LOX_OPCODE_COUNT(name, operands) + 1
+    LOX_OPCODES(LOX_OPCODE_COUNT)
+    #undef LOX_OPCODE_COUNT
+    ;
+
+// "OP_" and the name, for the disassembler and dispatch stats
+const char* opcodeName(OpCode op);
+// bytes taken by the instruction, the opcode included, not counting CLOSURE's upvalues
+int instructionLength(OpCode op);
+
+// bytecode for one function plus the constants it uses and a line for every byte
+class Chunk
+{
+    public:
+        void write(std::uint8_t byte, int line);
+        void write(OpCode op, int line);
+        // returns the index of the constant in the pool
+        int addConstant(Value value);
+        // returns the index of a new, empty inline cache
+        int addCache();
+        // drops the code from offset on and the constants and caches past the counts given,
+        // for code compiled only to check it for errors
+        void truncate(int offset, int constantCount, int cacheCount);
+        // swaps in rewritten code, lines has an entry for every byte of it
+        void replaceCode(const std::vector<std::uint8_t>& newCode, const std::vector<int>& newLines);
+        // the line of every byte of code, for passes that rewrite it
+        std::vector<int> expandLines() const;
+        // source line of the instruction at offset
+        int getLine(int offset) const;
+        // bytes taken by the instruction at offset, CLOSURE's upvalues included
+        int instructionLength(int offset) const;
+
+        // run length encoded, consecutive bytes are nearly always on the same line
+        struct LineRun
+        {
+            int line;
+            int count;
+        };
+
+        // for saving the line table and loading it back without going through write
+        const std::vector<LineRun>& lineRuns() const { return lines; }
+        void addLineRun(int line, int count);
+
+        std::vector<std::uint8_t> code;
+        std::vector<Value> constants;
+        std::vector<InlineCache> caches;
+
+    private:
+        std::vector<LineRun> lines;
+};
+#endif
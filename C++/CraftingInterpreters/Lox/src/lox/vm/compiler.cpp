@@ -0,0 +1,854 @@
+#include "compiler.h"
+#include <cstring>
+#include "peephole.h"
+
+// slots, upvalue indexes and argument counts are single byte operands
+static constexpr int MAX_LOCALS = 256;
+static constexpr int MAX_UPVALUES = 256;
+static constexpr int MAX_SHORT = UINT16_MAX;
+
+// No instruction leaves more than two values on the stack it didn't find there, and a loop
+// leaves the stack as it found it, so a call never uses more than its callee, its arguments
+// and two slots for every instruction.
+static int maxSlots(const LoxFunction* function)
+{
+    const Chunk& chunk = function->chunk;
+    int instructions = 0;
+    for (int offset = 0; offset < static_cast<int>(chunk.code.size()); offset += chunk.instructionLength(offset))
+    {
+        instructions++;
+    }
+    return 1 + function->arity + 2 * instructions;
+}
+
+Compiler::Compiler(Heap& heap, Globals& globals, ErrorReporter& reporter): heap(heap), globals(globals), reporter(reporter) {}
+
+LoxFunction* Compiler::compile(NodeList<Stmt*> statements)
+{
+    FunctionState script(nullptr, heap.allocate<LoxFunction>(), FunctionType::SCRIPT);
+    // slot 0 holds the function being called
+    script.locals.push_back(Local{"", 0});
+    current = &script;
+
+    for (const Stmt* stmt : statements) statement(stmt);
+    emitReturn();
+    finishFunction();
+
+    current = nullptr;
+    return hadError ? nullptr : script.function;
+}
+
+// after an error, operands can point at the wrong constants, and the code never runs anyway
+void Compiler::finishFunction()
+{
+    if (hadError) return;
+    fuseSuperinstructions(currentChunk());
+    current->function->maxSlots = maxSlots(current->function);
+}
+
+void Compiler::statement(const Stmt* stmt)
+{
+    line = stmt->line;
+
+    switch (stmt->type)
+    {
+        case StmtType::BLOCK:
+            beginScope();
+            for (const Stmt* inner : static_cast<const BlockStmt*>(stmt)->statements) statement(inner);
+            endScope();
+            break;
+        case StmtType::CLASS:
+            classDeclaration(static_cast<const ClassStmt*>(stmt));
+            break;
+        case StmtType::EXPRESSION:
+            expression(static_cast<const ExpressionStmt*>(stmt)->expression);
+            emit(OpCode::POP);
+            break;
+        case StmtType::FUNCTION:
+        {
+            const FunctionStmt* fun = static_cast<const FunctionStmt*>(stmt);
+            declareVariable(fun->name);
+            // a function can refer to itself, so it's usable before its body is compiled
+            if (current->scopeDepth > 0) markInitialized();
+            function(fun, FunctionType::FUNCTION);
+            defineVariable(fun->name);
+            break;
+        }
+        case StmtType::IF:
+            ifStatement(static_cast<const IfStmt*>(stmt));
+            break;
+        case StmtType::PRINT:
+            expression(static_cast<const PrintStmt*>(stmt)->expression);
+            emit(OpCode::PRINT);
+            break;
+        case StmtType::RETURN:
+            returnStatement(static_cast<const ReturnStmt*>(stmt));
+            break;
+        case StmtType::VAR:
+            varDeclaration(static_cast<const VarStmt*>(stmt));
+            break;
+        case StmtType::WHILE:
+            whileStatement(static_cast<const WhileStmt*>(stmt));
+            break;
+    }
+}
+
+void Compiler::classDeclaration(const ClassStmt* stmt)
+{
+    int nameConstant = identifierConstant(stmt->name);
+    declareVariable(stmt->name);
+
+    emit(OpCode::CLASS);
+    emitShort(nameConstant);
+    defineVariable(stmt->name);
+
+    ClassState classState{currentClass, stmt};
+    currentClass = &classState;
+
+    if (stmt->superclass)
+    {
+        if (stmt->superclass->name.lexeme == stmt->name.lexeme)
+        {
+            error(stmt->superclass->name, "A class can't inherit from itself.");
+        }
+
+        // the superclass stays on the stack as the methods' super
+        namedVariable(stmt->superclass->name, false);
+        beginScope();
+        addLocal(Token{TokenType::SUPER, "super", std::monostate{}, stmt->line});
+        markInitialized();
+
+        namedVariable(stmt->name, false);
+        emit(OpCode::INHERIT);
+    }
+
+    // the class stays on the stack while its methods are attached
+    namedVariable(stmt->name, false);
+    for (const FunctionStmt* method : stmt->methods)
+    {
+        line = method->line;
+        int methodConstant = identifierConstant(method->name);
+        FunctionType type = method->name.lexeme == "init" ? FunctionType::INITIALIZER : FunctionType::METHOD;
+        function(method, type);
+        emit(OpCode::METHOD);
+        emitShort(methodConstant);
+    }
+    emit(OpCode::POP);
+    if (stmt->superclass) endScope();
+
+    currentClass = classState.enclosing;
+}
+
+// compiles the body into a new LoxFunction and leaves a closure over it on the stack of the enclosing function
+void Compiler::function(const FunctionStmt* stmt, FunctionType type)
+{
+    FunctionState state(current, heap.allocate<LoxFunction>(), type);
+    state.function->name = heap.makeString(stmt->name.lexeme);
+    heap.writeBarrier(state.function, Value::nil(), Value::object(state.function->name));
+    // slot 0 holds the receiver in methods, and the function itself otherwise (unnamed so it can't be referenced)
+    bool hasReceiver = type == FunctionType::METHOD || type == FunctionType::INITIALIZER;
+    state.locals.push_back(Local{hasReceiver ? "this" : "", 0});
+    state.function->isMethod = hasReceiver;
+    current = &state;
+
+    beginScope();
+    for (const Token& param : stmt->params)
+    {
+        state.function->arity++;
+        declareVariable(param);
+        defineVariable(param);
+    }
+
+    for (const Stmt* inner : stmt->body) statement(inner);
+    emitReturn();
+    state.function->upvalueCount = static_cast<int>(state.upvalues.size());
+    finishFunction();
+
+    // no endScope, returning discards the whole frame (and closes its upvalues)
+    current = state.enclosing;
+    line = stmt->line;
+    emit(OpCode::CLOSURE);
+    emitShort(makeConstant(Value::object(state.function)));
+    for (const Upvalue& upvalue : state.upvalues)
+    {
+        emitByte(upvalue.isLocal ? 1 : 0);
+        emitByte(upvalue.index);
+    }
+}
+
+void Compiler::varDeclaration(const VarStmt* stmt)
+{
+    declareVariable(stmt->name);
+
+    if (stmt->initializer)
+    {
+        expression(stmt->initializer);
+    }
+    else
+    {
+        emit(OpCode::NIL);
+    }
+
+    line = stmt->line;
+    defineVariable(stmt->name);
+}
+
+void Compiler::ifStatement(const IfStmt* stmt)
+{
+    // a literal condition (usually left by the ConstantFolder) picks the branch now
+    if (stmt->condition->type == ExprType::LITERAL)
+    {
+        if (isTruthy(static_cast<const LiteralExpr*>(stmt->condition)->value))
+        {
+            statement(stmt->thenBranch);
+            if (stmt->elseBranch) deadStatement(stmt->elseBranch);
+        }
+        else
+        {
+            deadStatement(stmt->thenBranch);
+            if (stmt->elseBranch) statement(stmt->elseBranch);
+        }
+        return;
+    }
+
+    expression(stmt->condition);
+
+    int thenJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    statement(stmt->thenBranch);
+
+    int elseJump = emitJump(OpCode::JUMP);
+    patchJump(thenJump);
+    emit(OpCode::POP);
+
+    if (stmt->elseBranch) statement(stmt->elseBranch);
+    patchJump(elseJump);
+}
+
+void Compiler::returnStatement(const ReturnStmt* stmt)
+{
+    if (current->type == FunctionType::SCRIPT)
+    {
+        error(stmt->keyword, "Can't return from top-level code.");
+    }
+
+    if (stmt->value == nullptr)
+    {
+        emitReturn();
+        return;
+    }
+
+    if (current->type == FunctionType::INITIALIZER)
+    {
+        error(stmt->keyword, "Can't return a value from an initializer.");
+    }
+
+    // the call's frame replaces this one, so tail recursion runs in constant stack
+    if (stmt->value->type == ExprType::CALL && current->type != FunctionType::INITIALIZER)
+    {
+        call(static_cast<const CallExpr*>(stmt->value), true);
+    }
+    else
+    {
+        expression(stmt->value);
+    }
+    emit(OpCode::RETURN);
+}
+
+void Compiler::whileStatement(const WhileStmt* stmt)
+{
+    int loopStart = static_cast<int>(currentChunk().code.size());
+
+    // with a literal condition the loop either never runs or never needs testing
+    if (stmt->condition->type == ExprType::LITERAL)
+    {
+        if (!isTruthy(static_cast<const LiteralExpr*>(stmt->condition)->value))
+        {
+            deadStatement(stmt->body);
+            return;
+        }
+        statement(stmt->body);
+        emitLoop(loopStart);
+        return;
+    }
+
+    expression(stmt->condition);
+
+    int exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    statement(stmt->body);
+    emitLoop(loopStart);
+
+    patchJump(exitJump);
+    emit(OpCode::POP);
+}
+
+// compiled for its errors but leaves no code, for branches that can't run
+void Compiler::deadStatement(const Stmt* stmt)
+{
+    Mark start = mark();
+    statement(stmt);
+    dropSince(start);
+}
+
+void Compiler::expression(const Expr* expr)
+{
+    line = expr->line;
+
+    switch (expr->type)
+    {
+        case ExprType::ASSIGN:
+        {
+            const AssignExpr* assign = static_cast<const AssignExpr*>(expr);
+            expression(assign->value);
+            namedVariable(assign->name, true);
+            break;
+        }
+        case ExprType::BINARY:
+            binary(static_cast<const BinaryExpr*>(expr));
+            break;
+        case ExprType::CALL:
+            call(static_cast<const CallExpr*>(expr), false);
+            break;
+        case ExprType::GET:
+        {
+            const GetExpr* get = static_cast<const GetExpr*>(expr);
+            expression(get->object);
+            line = get->line;
+            emit(OpCode::GET_PROPERTY);
+            emitShort(identifierConstant(get->name));
+            emitShort(makeCache());
+            break;
+        }
+        case ExprType::GROUPING:
+            expression(static_cast<const GroupingExpr*>(expr)->expression);
+            break;
+        case ExprType::LITERAL:
+            literal(static_cast<const LiteralExpr*>(expr));
+            break;
+        case ExprType::LOGICAL:
+            logical(static_cast<const LogicalExpr*>(expr));
+            break;
+        case ExprType::SET:
+        {
+            const SetExpr* set = static_cast<const SetExpr*>(expr);
+            expression(set->object);
+            expression(set->value);
+            line = set->line;
+            emit(OpCode::SET_PROPERTY);
+            emitShort(identifierConstant(set->name));
+            emitShort(makeCache());
+            break;
+        }
+        case ExprType::SUPER:
+            superAccess(static_cast<const SuperExpr*>(expr), false, 0);
+            break;
+        case ExprType::THIS:
+        {
+            const ThisExpr* thisExpr = static_cast<const ThisExpr*>(expr);
+            if (checkClassContext(thisExpr->keyword, false)) namedVariable(thisExpr->keyword, false);
+            break;
+        }
+        case ExprType::UNARY:
+        {
+            const UnaryExpr* unary = static_cast<const UnaryExpr*>(expr);
+            expression(unary->right);
+            line = unary->line;
+            emit(unary->op.type == TokenType::MINUS ? OpCode::NEGATE : OpCode::NOT);
+            break;
+        }
+        case ExprType::VARIABLE:
+            namedVariable(static_cast<const VariableExpr*>(expr)->name, false);
+            break;
+    }
+}
+
+void Compiler::binary(const BinaryExpr* expr)
+{
+    expression(expr->left);
+    expression(expr->right);
+    line = expr->line;
+
+    // !=, >= and <= are the negation of another comparison
+    switch (expr->op.type)
+    {
+        case TokenType::BANG_EQUAL: emit(OpCode::EQUAL); emit(OpCode::NOT); break;
+        case TokenType::EQUAL_EQUAL: emit(OpCode::EQUAL); break;
+        case TokenType::GREATER: emit(OpCode::GREATER); break;
+        case TokenType::GREATER_EQUAL: emit(OpCode::LESS); emit(OpCode::NOT); break;
+        case TokenType::LESS: emit(OpCode::LESS); break;
+        case TokenType::LESS_EQUAL: emit(OpCode::GREATER); emit(OpCode::NOT); break;
+        case TokenType::PLUS: emit(OpCode::ADD); break;
+        case TokenType::MINUS: emit(OpCode::SUBTRACT); break;
+        case TokenType::STAR: emit(OpCode::MULTIPLY); break;
+        case TokenType::SLASH: emit(OpCode::DIVIDE); break;
+        default: break; // the parser doesn't produce any other binary operator
+    }
+}
+
+// tail is for a call being returned, super calls are never made as tail calls
+void Compiler::call(const CallExpr* expr, bool tail)
+{
+    int argCount = expr->arguments.size();
+
+    // calling a method straight away skips creating a bound method
+    if (expr->callee->type == ExprType::GET)
+    {
+        const GetExpr* get = static_cast<const GetExpr*>(expr->callee);
+        expression(get->object);
+        for (const Expr* argument : expr->arguments) expression(argument);
+
+        line = expr->line;
+        emit(tail ? OpCode::TAIL_INVOKE : OpCode::INVOKE);
+        emitShort(identifierConstant(get->name));
+        emitByte(static_cast<std::uint8_t>(argCount));
+        emitShort(makeCache());
+        return;
+    }
+
+    if (expr->callee->type == ExprType::SUPER)
+    {
+        const SuperExpr* super = static_cast<const SuperExpr*>(expr->callee);
+        if (!checkClassContext(super->keyword, true)) return;
+
+        namedVariable(Token{TokenType::THIS, "this", std::monostate{}, super->line}, false);
+        for (const Expr* argument : expr->arguments) expression(argument);
+        superAccess(super, true, argCount);
+        return;
+    }
+
+    expression(expr->callee);
+    for (const Expr* argument : expr->arguments) expression(argument);
+
+    line = expr->line;
+    emit(tail ? OpCode::TAIL_CALL : OpCode::CALL);
+    emitByte(static_cast<std::uint8_t>(argCount));
+}
+
+void Compiler::literal(const LiteralExpr* expr)
+{
+    const LiteralValue& value = expr->value;
+
+    if (std::holds_alternative<std::monostate>(value))
+    {
+        emit(OpCode::NIL);
+    }
+    else if (const bool* boolean = std::get_if<bool>(&value))
+    {
+        emit(*boolean ? OpCode::TRUE : OpCode::FALSE);
+    }
+    else if (const double* number = std::get_if<double>(&value))
+    {
+        emit(OpCode::CONSTANT);
+        emitShort(numberConstant(*number));
+    }
+    else
+    {
+        emit(OpCode::CONSTANT);
+        emitShort(stringConstant(heap.makeString(std::get<std::string_view>(value))));
+    }
+}
+
+void Compiler::logical(const LogicalExpr* expr)
+{
+    // a literal left side decides which operand is the result, the other one can't run
+    if (expr->left->type == ExprType::LITERAL)
+    {
+        bool truthy = isTruthy(static_cast<const LiteralExpr*>(expr->left)->value);
+        bool leftIsResult = expr->op.type == TokenType::AND ? !truthy : truthy;
+        if (leftIsResult)
+        {
+            expression(expr->left);
+            deadExpression(expr->right);
+        }
+        else
+        {
+            expression(expr->right);
+        }
+        return;
+    }
+
+    expression(expr->left);
+    line = expr->line;
+
+    if (expr->op.type == TokenType::AND)
+    {
+        // left is falsey, it's the result and right is skipped
+        int endJump = emitJump(OpCode::JUMP_IF_FALSE);
+        emit(OpCode::POP);
+        expression(expr->right);
+        patchJump(endJump);
+    }
+    else
+    {
+        // left is truthy, it's the result and right is skipped
+        int elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+        int endJump = emitJump(OpCode::JUMP);
+        patchJump(elseJump);
+        emit(OpCode::POP);
+        expression(expr->right);
+        patchJump(endJump);
+    }
+}
+
+void Compiler::deadExpression(const Expr* expr)
+{
+    Mark start = mark();
+    expression(expr);
+    dropSince(start);
+}
+
+Compiler::Mark Compiler::mark()
+{
+    const Chunk& chunk = currentChunk();
+    return Mark{static_cast<int>(chunk.code.size()), static_cast<int>(chunk.constants.size()),
+                static_cast<int>(chunk.caches.size()), globals.count()};
+}
+
+// a dead branch's code goes, and so does everything only it used: its constants (nested
+// functions included), caches and the global slots it was first to name
+void Compiler::dropSince(const Mark& start)
+{
+    currentChunk().truncate(start.code, start.constants, start.caches);
+    globals.truncate(start.globals);
+
+    for (auto it = current->stringConstants.begin(); it != current->stringConstants.end(); )
+    {
+        it = it->second >= start.constants ? current->stringConstants.erase(it) : std::next(it);
+    }
+    for (auto it = current->numberConstants.begin(); it != current->numberConstants.end(); )
+    {
+        it = it->second >= start.constants ? current->numberConstants.erase(it) : std::next(it);
+    }
+}
+
+// super.method, or super.method(args) when invoke is set and the receiver and arguments are already pushed
+void Compiler::superAccess(const SuperExpr* expr, bool invoke, int argCount)
+{
+    if (!invoke)
+    {
+        if (!checkClassContext(expr->keyword, true)) return;
+        namedVariable(Token{TokenType::THIS, "this", std::monostate{}, expr->line}, false);
+    }
+
+    namedVariable(Token{TokenType::SUPER, "super", std::monostate{}, expr->line}, false);
+
+    line = expr->line;
+    emit(invoke ? OpCode::SUPER_INVOKE : OpCode::GET_SUPER);
+    emitShort(identifierConstant(expr->method));
+    if (invoke) emitByte(static_cast<std::uint8_t>(argCount));
+}
+
+void Compiler::namedVariable(const Token& name, bool assign)
+{
+    int slot = resolveLocal(current, name);
+    if (slot >= 0)
+    {
+        emit(assign ? OpCode::SET_LOCAL : OpCode::GET_LOCAL);
+        emitByte(static_cast<std::uint8_t>(slot));
+        return;
+    }
+
+    int upvalue = resolveUpvalue(current, name);
+    if (upvalue >= 0)
+    {
+        emit(assign ? OpCode::SET_UPVALUE : OpCode::GET_UPVALUE);
+        emitByte(static_cast<std::uint8_t>(upvalue));
+        return;
+    }
+
+    emit(assign ? OpCode::SET_GLOBAL : OpCode::GET_GLOBAL);
+    emitShort(globalSlot(name));
+}
+
+void Compiler::beginScope()
+{
+    current->scopeDepth++;
+}
+
+void Compiler::endScope()
+{
+    current->scopeDepth--;
+
+    std::vector<Local>& locals = current->locals;
+    while (!locals.empty() && locals.back().depth > current->scopeDepth)
+    {
+        emit(locals.back().captured ? OpCode::CLOSE_UPVALUE : OpCode::POP);
+        locals.pop_back();
+    }
+}
+
+// locals are declared when their name is seen and defined once their initializer has run,
+// globals are only defined
+void Compiler::declareVariable(const Token& name)
+{
+    if (current->scopeDepth == 0) return;
+
+    for (auto local = current->locals.rbegin(); local != current->locals.rend(); ++local)
+    {
+        if (local->depth != -1 && local->depth < current->scopeDepth) break;
+
+        if (local->name == name.lexeme)
+        {
+            error(name, "Already a variable with this name in this scope.");
+        }
+    }
+
+    addLocal(name);
+}
+
+void Compiler::defineVariable(const Token& name)
+{
+    if (current->scopeDepth > 0)
+    {
+        markInitialized();
+        return;
+    }
+
+    emit(OpCode::DEFINE_GLOBAL);
+    emitShort(globalSlot(name));
+}
+
+void Compiler::addLocal(const Token& name)
+{
+    if (current->locals.size() == MAX_LOCALS)
+    {
+        error(name, "Too many local variables in function.");
+        return;
+    }
+
+    current->locals.push_back(Local{name.lexeme, -1});
+}
+
+void Compiler::markInitialized()
+{
+    current->locals.back().depth = current->scopeDepth;
+}
+
+// -1 if name isn't a local of the function state belongs to
+int Compiler::resolveLocal(FunctionState* state, const Token& name)
+{
+    for (int i = static_cast<int>(state->locals.size()) - 1; i >= 0; i--)
+    {
+        const Local& local = state->locals[i];
+        if (local.name == name.lexeme)
+        {
+            if (local.depth == -1) error(name, "Can't read local variable in its own initializer.");
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// -1 if name isn't a local of any function enclosing the one state belongs to,
+// otherwise the index of the upvalue state (and every function in between) now has for it
+int Compiler::resolveUpvalue(FunctionState* state, const Token& name)
+{
+    if (state->enclosing == nullptr) return -1;
+
+    int local = resolveLocal(state->enclosing, name);
+    if (local >= 0)
+    {
+        state->enclosing->locals[local].captured = true;
+        return addUpvalue(state, static_cast<std::uint8_t>(local), true);
+    }
+
+    int upvalue = resolveUpvalue(state->enclosing, name);
+    if (upvalue >= 0) return addUpvalue(state, static_cast<std::uint8_t>(upvalue), false);
+
+    return -1;
+}
+
+// a variable captured more than once shares one upvalue
+int Compiler::addUpvalue(FunctionState* state, std::uint8_t index, bool isLocal)
+{
+    std::vector<Upvalue>& upvalues = state->upvalues;
+    for (std::size_t i = 0; i < upvalues.size(); i++)
+    {
+        if (upvalues[i].index == index && upvalues[i].isLocal == isLocal) return static_cast<int>(i);
+    }
+
+    if (upvalues.size() == MAX_UPVALUES)
+    {
+        error("Too many closure variables in function.");
+        return 0;
+    }
+
+    upvalues.push_back(Upvalue{index, isLocal});
+    return static_cast<int>(upvalues.size()) - 1;
+}
+
+// reports and returns false if 'this' or 'super' (named by keyword) can't be used here
+bool Compiler::checkClassContext(const Token& keyword, bool needsSuperclass)
+{
+    bool isSuper = keyword.type == TokenType::SUPER;
+
+    if (currentClass == nullptr)
+    {
+        error(keyword, isSuper ? "Can't use 'super' outside of a class." : "Can't use 'this' outside of a class.");
+        return false;
+    }
+
+    if (needsSuperclass && currentClass->declaration->superclass == nullptr)
+    {
+        error(keyword, "Can't use 'super' in a class with no superclass.");
+        return false;
+    }
+
+    return true;
+}
+
+Chunk& Compiler::currentChunk()
+{
+    return current->function->chunk;
+}
+
+void Compiler::emit(OpCode op)
+{
+    currentChunk().write(op, line);
+}
+
+void Compiler::emitByte(std::uint8_t byte)
+{
+    currentChunk().write(byte, line);
+}
+
+// 16 bit operands are stored high byte first
+void Compiler::emitShort(int value)
+{
+    emitByte(static_cast<std::uint8_t>((value >> 8) & 0xff));
+    emitByte(static_cast<std::uint8_t>(value & 0xff));
+}
+
+void Compiler::emitConstant(Value value)
+{
+    emit(OpCode::CONSTANT);
+    emitShort(makeConstant(value));
+}
+
+// returns where the placeholder offset was written, for patchJump
+int Compiler::emitJump(OpCode op)
+{
+    emit(op);
+    emitShort(0xffff);
+    return static_cast<int>(currentChunk().code.size()) - 2;
+}
+
+void Compiler::patchJump(int offset)
+{
+    // -2 to skip over the jump's own operand
+    int jump = static_cast<int>(currentChunk().code.size()) - offset - 2;
+    if (jump > MAX_SHORT) error("Too much code to jump over.");
+
+    currentChunk().code[offset] = static_cast<std::uint8_t>((jump >> 8) & 0xff);
+    currentChunk().code[offset + 1] = static_cast<std::uint8_t>(jump & 0xff);
+}
+
+void Compiler::emitLoop(int loopStart)
+{
+    emit(OpCode::LOOP);
+
+    // +2 to also jump back over LOOP's own operand
+    int offset = static_cast<int>(currentChunk().code.size()) - loopStart + 2;
+    if (offset > MAX_SHORT) error("Loop body too large.");
+
+    emitShort(offset);
+}
+
+void Compiler::emitReturn()
+{
+    // an initializer always returns the new instance
+    if (current->type == FunctionType::INITIALIZER)
+    {
+        emit(OpCode::GET_LOCAL);
+        emitByte(0);
+    }
+    else
+    {
+        emit(OpCode::NIL);
+    }
+
+    emit(OpCode::RETURN);
+}
+
+int Compiler::makeConstant(Value value)
+{
+    // an interned string can still be in the nursery, functions never are
+    heap.writeBarrier(current->function, Value::nil(), value);
+    int index = currentChunk().addConstant(value);
+    if (index > MAX_SHORT)
+    {
+        error("Too many constants in one chunk.");
+        return 0;
+    }
+    return index;
+}
+
+int Compiler::makeCache()
+{
+    int index = currentChunk().addCache();
+    if (index > MAX_SHORT)
+    {
+        error("Too many property accesses in one chunk.");
+        return 0;
+    }
+    return index;
+}
+
+int Compiler::stringConstant(LoxString* string)
+{
+    auto existing = current->stringConstants.find(string);
+    if (existing != current->stringConstants.end()) return existing->second;
+
+    int index = makeConstant(Value::object(string));
+    current->stringConstants.emplace(string, index);
+    return index;
+}
+
+int Compiler::numberConstant(double number)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    auto existing = current->numberConstants.find(bits);
+    if (existing != current->numberConstants.end()) return existing->second;
+
+    int index = makeConstant(Value::number(number));
+    current->numberConstants.emplace(bits, index);
+    return index;
+}
+
+int Compiler::identifierConstant(const Token& name)
+{
+    return stringConstant(identifierString(name));
+}
+
+LoxString* Compiler::identifierString(const Token& name)
+{
+    // interned by the scanner already, unless it's 'this' or another keyword standing in for a name
+    if (LoxString* const* interned = std::get_if<LoxString*>(&name.literal)) return *interned;
+    return heap.makeString(name.lexeme);
+}
+
+int Compiler::globalSlot(const Token& name)
+{
+    int slot = globals.resolve(identifierString(name));
+    if (slot > MAX_SHORT)
+    {
+        error(name, "Too many global variables.");
+        return 0;
+    }
+    return slot;
+}
+
+void Compiler::error(const Token& token, const char* message)
+{
+    reporter.error(token, message);
+    hadError = true;
+}
+
+void Compiler::error(const char* message)
+{
+    reporter.error(line, message);
+    hadError = true;
+}
@@ -0,0 +1,146 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "chunk.h"
+#include "globals.h"
+#include "heap.h"
+#include "lox/error_reporter.h"
+#include "lox/parser/ast.h"
+#include "lox/types/lox_function.h"
+
+// Walks the syntax tree once and emits bytecode, producing the script as a
+// function of no arguments. Functions and methods found on the way become
+// LoxFunction constants of the function they are declared in.
+// - locals live in stack slots worked out here, anything not found in the
+//   current function's scopes is a global, resolved here to its slot in
+//   the VM's Globals
+// - a local of an enclosing function becomes an upvalue of every function
+//   between it and its use, and the closure made for each function is
+//   told where to find its upvalues when it's created
+// - super is a hidden local around a subclass's methods, so they capture
+//   the superclass as it was when the class was declared
+// - an if, while, and or or with a literal condition emits only the code
+//   that can run, the rest is still compiled to report its errors and then
+//   dropped along with its constants, caches and new global slots
+// - each function's finished chunk goes through fuseSuperinstructions
+// - errors are reported to the ErrorReporter and compiling carries on
+class Compiler
+{
+    public:
+        Compiler(Heap& heap, Globals& globals, ErrorReporter& reporter);
+
+        // nullptr if there were compile errors
+        LoxFunction* compile(NodeList<Stmt*> statements);
+
+    private:
+        enum class FunctionType { SCRIPT, FUNCTION, METHOD, INITIALIZER };
+
+        struct Local
+        {
+            std::string_view name;
+            int depth; // -1 while its initializer is being compiled
+            bool captured = false; // by a closure, so it's closed rather than popped at the end of its scope
+        };
+
+        struct Upvalue
+        {
+            std::uint8_t index; // slot of the enclosing function's local, or its upvalue
+            bool isLocal;
+        };
+
+        // per function being compiled, they nest as function declarations do
+        struct FunctionState
+        {
+            FunctionState* enclosing;
+            LoxFunction* function;
+            FunctionType type;
+            std::vector<Local> locals;
+            std::vector<Upvalue> upvalues;
+            int scopeDepth = 0;
+            // constant pool entries already added, so repeated names and literals share one
+            std::unordered_map<LoxString*, int> stringConstants;
+            // keyed by bit pattern, -0 and 0 are different constants and NaN can be found again
+            std::unordered_map<std::uint64_t, int> numberConstants;
+
+            FunctionState(FunctionState* enclosing, LoxFunction* function, FunctionType type):
+                enclosing(enclosing), function(function), type(type) {}
+        };
+
+        struct ClassState
+        {
+            ClassState* enclosing;
+            const ClassStmt* declaration;
+        };
+
+        void finishFunction();
+        void statement(const Stmt* stmt);
+        void classDeclaration(const ClassStmt* stmt);
+        void function(const FunctionStmt* stmt, FunctionType type);
+        void varDeclaration(const VarStmt* stmt);
+        void ifStatement(const IfStmt* stmt);
+        void returnStatement(const ReturnStmt* stmt);
+        void whileStatement(const WhileStmt* stmt);
+        void deadStatement(const Stmt* stmt);
+
+        void expression(const Expr* expr);
+        void binary(const BinaryExpr* expr);
+        void call(const CallExpr* expr, bool tail);
+        void literal(const LiteralExpr* expr);
+        void logical(const LogicalExpr* expr);
+        void deadExpression(const Expr* expr);
+        // how far the current chunk and the globals went before a dead branch was compiled
+        struct Mark
+        {
+            int code;
+            int constants;
+            int caches;
+            int globals;
+        };
+        Mark mark();
+        void dropSince(const Mark& start);
+        void superAccess(const SuperExpr* expr, bool invoke, int argCount);
+        void namedVariable(const Token& name, bool assign);
+
+        void beginScope();
+        void endScope();
+        void declareVariable(const Token& name);
+        void defineVariable(const Token& name);
+        void addLocal(const Token& name);
+        void markInitialized();
+        int resolveLocal(FunctionState* state, const Token& name);
+        int resolveUpvalue(FunctionState* state, const Token& name);
+        int addUpvalue(FunctionState* state, std::uint8_t index, bool isLocal);
+        bool checkClassContext(const Token& keyword, bool needsSuperclass);
+
+        Chunk& currentChunk();
+        void emit(OpCode op);
+        void emitByte(std::uint8_t byte);
+        void emitShort(int value);
+        void emitConstant(Value value);
+        int emitJump(OpCode op);
+        void patchJump(int offset);
+        void emitLoop(int loopStart);
+        void emitReturn();
+        int makeConstant(Value value);
+        int stringConstant(LoxString* string);
+        int numberConstant(double number);
+        int identifierConstant(const Token& name);
+        int makeCache();
+        LoxString* identifierString(const Token& name);
+        int globalSlot(const Token& name);
+
+        void error(const Token& token, const char* message);
+        void error(const char* message);
+
+        Heap& heap;
+        Globals& globals;
+        ErrorReporter& reporter;
+        FunctionState* current = nullptr;
+        ClassState* currentClass = nullptr;
+        int line = 1; // of the node being compiled, recorded against every byte emitted
+        bool hadError = false;
+};
+#endif
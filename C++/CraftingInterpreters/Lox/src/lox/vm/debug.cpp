@@ -0,0 +1,210 @@
+#include "debug.h"
+#include <cstdio>
+#include <vector>
+
+static int readShort(const Chunk& chunk, int offset)
+{
+    return (chunk.code[offset] << 8) | chunk.code[offset + 1];
+}
+
+std::string Disassembler::disassemble(LoxFunction* function)
+{
+    out.clear();
+
+    // breadth first through nested functions, in the order they appear
+    std::vector<LoxFunction*> pending{function};
+    for (std::size_t i = 0; i < pending.size(); i++)
+    {
+        chunk(pending[i]->chunk, pending[i]->toString());
+        for (const Value& constant : pending[i]->chunk.constants)
+        {
+            if (constant.isObjectType(ObjectType::FUNCTION)) pending.push_back(constant.asObject<LoxFunction>());
+        }
+    }
+
+    return out;
+}
+
+void Disassembler::chunk(const Chunk& chunk, const std::string& name)
+{
+    out += "== " + name + " ==\n";
+    for (int offset = 0; offset < static_cast<int>(chunk.code.size()); )
+    {
+        offset = instruction(chunk, offset);
+    }
+}
+
+int Disassembler::instruction(const Chunk& chunk, int offset)
+{
+    char prefix[32];
+    int line = chunk.getLine(offset);
+    if (offset > 0 && line == chunk.getLine(offset - 1))
+    {
+        std::snprintf(prefix, sizeof(prefix), "%04d    | ", offset);
+    }
+    else
+    {
+        std::snprintf(prefix, sizeof(prefix), "%04d %4d ", offset, line);
+    }
+    out += prefix;
+
+    OpCode op = static_cast<OpCode>(chunk.code[offset]);
+    const char* name = opcodeName(op);
+    switch (op)
+    {
+        case OpCode::GET_GLOBAL:
+        case OpCode::DEFINE_GLOBAL:
+        case OpCode::SET_GLOBAL:
+            return globalInstruction(name, chunk, offset);
+        case OpCode::CONSTANT:
+        case OpCode::GET_SUPER:
+        case OpCode::CLASS:
+        case OpCode::METHOD:
+            return constantInstruction(name, chunk, offset);
+        case OpCode::GET_LOCAL:
+        case OpCode::SET_LOCAL:
+        case OpCode::CALL:
+        case OpCode::TAIL_CALL:
+        case OpCode::SET_LOCAL_POP:
+        case OpCode::GET_UPVALUE:
+        case OpCode::SET_UPVALUE:
+            return byteInstruction(name, chunk, offset);
+        case OpCode::CLOSURE:
+            return closureInstruction(name, chunk, offset);
+        case OpCode::GET_LOCAL_CONSTANT:
+        case OpCode::ADD_LOCAL_CONSTANT:
+        case OpCode::SUBTRACT_LOCAL_CONSTANT:
+            return localConstantInstruction(name, chunk, offset);
+        case OpCode::GET_LOCAL_PROPERTY:
+            return localPropertyInstruction(name, chunk, offset);
+        case OpCode::GET_PROPERTY:
+        case OpCode::SET_PROPERTY:
+            return propertyInstruction(name, chunk, offset);
+        case OpCode::INVOKE:
+        case OpCode::TAIL_INVOKE:
+        case OpCode::SUPER_INVOKE:
+            return invokeInstruction(name, chunk, offset);
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_FALSE_POP:
+        case OpCode::LESS_JUMP_IF_FALSE:
+            return jumpInstruction(name, 1, chunk, offset);
+        case OpCode::LOOP:
+            return jumpInstruction(name, -1, chunk, offset);
+        default:
+            return simpleInstruction(name, offset);
+    }
+}
+
+int Disassembler::simpleInstruction(const char* name, int offset)
+{
+    out += name;
+    out += '\n';
+    return offset + 1;
+}
+
+int Disassembler::byteInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d\n", name, chunk.code[offset + 1]);
+    out += line;
+    return offset + 2;
+}
+
+int Disassembler::constantInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int constant = readShort(chunk, offset + 1);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d '", name, constant);
+    out += line + chunk.constants[constant].toString() + "'\n";
+    return offset + 3;
+}
+
+int Disassembler::globalInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int slot = readShort(chunk, offset + 1);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d '", name, slot);
+    out += line + globals.name(slot)->toString() + "'\n";
+    return offset + 3;
+}
+
+int Disassembler::propertyInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int constant = readShort(chunk, offset + 1);
+    int cache = readShort(chunk, offset + 3);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d '", name, constant);
+    out += line + chunk.constants[constant].toString();
+    std::snprintf(line, sizeof(line), "' ic %d\n", cache);
+    out += line;
+    return offset + 5;
+}
+
+int Disassembler::localConstantInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int constant = readShort(chunk, offset + 2);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d %4d '", name, chunk.code[offset + 1], constant);
+    out += line + chunk.constants[constant].toString() + "'\n";
+    return offset + 4;
+}
+
+int Disassembler::localPropertyInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int constant = readShort(chunk, offset + 2);
+    int cache = readShort(chunk, offset + 4);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d %4d '", name, chunk.code[offset + 1], constant);
+    out += line + chunk.constants[constant].toString();
+    std::snprintf(line, sizeof(line), "' ic %d\n", cache);
+    out += line;
+    return offset + 6;
+}
+
+// the function, then a line for each upvalue the closure captures
+int Disassembler::closureInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int constant = readShort(chunk, offset + 1);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d '", name, constant);
+    out += line + chunk.constants[constant].toString() + "'\n";
+
+    const LoxFunction* function = chunk.constants[constant].asObject<LoxFunction>();
+    offset += 3;
+    for (int i = 0; i < function->upvalueCount; i++, offset += 2)
+    {
+        bool isLocal = chunk.code[offset];
+        std::snprintf(line, sizeof(line), "%04d    |                     %s %d\n", offset, isLocal ? "local" : "upvalue",
+                      chunk.code[offset + 1]);
+        out += line;
+    }
+    return offset;
+}
+
+// SUPER_INVOKE has no cache, the superclass is the same every time
+int Disassembler::invokeInstruction(const char* name, const Chunk& chunk, int offset)
+{
+    int constant = readShort(chunk, offset + 1);
+    int argCount = chunk.code[offset + 3];
+    bool cached = static_cast<OpCode>(chunk.code[offset]) != OpCode::SUPER_INVOKE;
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s (%d args) %4d '", name, argCount, constant);
+    out += line + chunk.constants[constant].toString() + "'";
+    if (cached)
+    {
+        std::snprintf(line, sizeof(line), " ic %d", readShort(chunk, offset + 4));
+        out += line;
+    }
+    out += '\n';
+    return offset + (cached ? 6 : 4);
+}
+
+int Disassembler::jumpInstruction(const char* name, int sign, const Chunk& chunk, int offset)
+{
+    int jump = readShort(chunk, offset + 1);
+    char line[64];
+    std::snprintf(line, sizeof(line), "%-16s %4d -> %d\n", name, offset, offset + 3 + sign * jump);
+    out += line;
+    return offset + 3;
+}
@@ -0,0 +1,38 @@
+#ifndef DEBUG_H
+#define DEBUG_H
+#include <string>
+#include "chunk.h"
+#include "globals.h"
+#include "lox/types/lox_function.h"
+
+// Prints compiled bytecode one instruction per line, for checking what the
+// compiler made of a script. Functions found in the constant pool are
+// disassembled after the function that uses them.
+class Disassembler
+{
+    public:
+        // global operands are shown with the names globals gives their slots
+        explicit Disassembler(const Globals& globals): globals(globals) {}
+
+        std::string disassemble(LoxFunction* function);
+
+    private:
+        void chunk(const Chunk& chunk, const std::string& name);
+        // returns the offset of the next instruction
+        int instruction(const Chunk& chunk, int offset);
+        int simpleInstruction(const char* name, int offset);
+        int byteInstruction(const char* name, const Chunk& chunk, int offset);
+        int constantInstruction(const char* name, const Chunk& chunk, int offset);
+        int globalInstruction(const char* name, const Chunk& chunk, int offset);
+        int propertyInstruction(const char* name, const Chunk& chunk, int offset);
+        // the superinstructions that start with GET_LOCAL
+        int localConstantInstruction(const char* name, const Chunk& chunk, int offset);
+        int localPropertyInstruction(const char* name, const Chunk& chunk, int offset);
+        int closureInstruction(const char* name, const Chunk& chunk, int offset);
+        int invokeInstruction(const char* name, const Chunk& chunk, int offset);
+        int jumpInstruction(const char* name, int sign, const Chunk& chunk, int offset);
+
+        const Globals& globals;
+        std::string out;
+};
+#endif
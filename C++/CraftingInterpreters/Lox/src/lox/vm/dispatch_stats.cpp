@@ -0,0 +1,49 @@
+#include "dispatch_stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "peephole.h"
+
+// the most frequent ops and pairs are what's worth reading
+static constexpr int TOP = 12;
+
+std::string DispatchStats::report() const
+{
+    char line[160];
+    std::string out;
+    // each superinstruction run is a dispatch for every instruction it replaced but one
+    long saved = 0;
+    for (int op = 0; op < OPCODE_COUNT; op++) saved += ops[op] * (fusedInstructions(static_cast<OpCode>(op)) - 1);
+    long unfused = dispatches + saved;
+    std::snprintf(line, sizeof(line), "dispatch: %ld instructions, %ld saved by superinstructions (%.1f%% fewer)\n",
+                  dispatches, saved, unfused == 0 ? 0 : 100.0 * saved / unfused);
+    out += line;
+
+    std::vector<int> byCount;
+    for (int op = 0; op < OPCODE_COUNT; op++) if (ops[op] > 0) byCount.push_back(op);
+    std::sort(byCount.begin(), byCount.end(), [this](int a, int b) { return ops[a] > ops[b]; });
+    if (byCount.size() > TOP) byCount.resize(TOP);
+    for (int op : byCount)
+    {
+        std::snprintf(line, sizeof(line), "dispatch: %-20s %12ld %5.1f%%\n", opcodeName(static_cast<OpCode>(op)),
+                      ops[op], 100.0 * ops[op] / dispatches);
+        out += line;
+    }
+
+    std::vector<std::pair<int, int>> pairsByCount;
+    for (int a = 0; a < OPCODE_COUNT; a++)
+    {
+        for (int b = 0; b < OPCODE_COUNT; b++) if (pairs[a][b] > 0) pairsByCount.emplace_back(a, b);
+    }
+    std::sort(pairsByCount.begin(), pairsByCount.end(), [this](std::pair<int, int> x, std::pair<int, int> y) {
+        return pairs[x.first][x.second] > pairs[y.first][y.second];
+    });
+    if (pairsByCount.size() > TOP) pairsByCount.resize(TOP);
+    for (auto [a, b] : pairsByCount)
+    {
+        std::snprintf(line, sizeof(line), "dispatch: %-20s %-20s %12ld %5.1f%%\n", opcodeName(static_cast<OpCode>(a)),
+                      opcodeName(static_cast<OpCode>(b)), pairs[a][b], 100.0 * pairs[a][b] / dispatches);
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,30 @@
+#ifndef DISPATCH_STATS_H
+#define DISPATCH_STATS_H
+#include <array>
+#include <string>
+#include "chunk.h"
+
+// How often each instruction and each pair of consecutive instructions was
+// dispatched, shown with --dispatch-stats. Counting costs more than some of
+// the instructions themselves, so the VM only does it when built with
+// LOX_DISPATCH_STATS. The pair profile is what the superinstructions were
+// picked from.
+struct DispatchStats
+{
+    long dispatches = 0;
+    std::array<long, OPCODE_COUNT> ops{};
+    // pairs[a][b] counts b dispatched straight after a, calls and returns included
+    std::array<std::array<long, OPCODE_COUNT>, OPCODE_COUNT> pairs{};
+    OpCode previous = OpCode::RETURN;
+
+    void record(OpCode op)
+    {
+        dispatches++;
+        ops[static_cast<int>(op)]++;
+        pairs[static_cast<int>(previous)][static_cast<int>(op)]++;
+        previous = op;
+    }
+
+    std::string report() const;
+};
+#endif
@@ -0,0 +1,27 @@
+#include "globals.h"
+
+int Globals::resolve(LoxString* name)
+{
+    if (Value* index = indices.find(name)) return static_cast<int>(index->asNumber());
+
+    int slot = count();
+    indices.set(name, Value::number(slot));
+    slots.push_back(Slot{Value::nil(), false, name});
+    return slot;
+}
+
+void Globals::truncate(int count)
+{
+    for (int slot = count; slot < this->count(); slot++) indices.remove(slots[slot].name);
+    slots.resize(count);
+}
+
+void Globals::trace(Tracer& tracer)
+{
+    indices.trace(tracer);
+    for (Slot& slot : slots)
+    {
+        tracer.visit(slot.name);
+        tracer.visit(slot.value);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef GLOBALS_H
+#define GLOBALS_H
+#include <vector>
+#include "table.h"
+#include "lox/types/value.h"
+#include "lox/types/lox_string.h"
+
+// Global variables, stored densely by slot so the VM reads and writes them
+// by index. The compiler gives a name its slot the first time it meets it,
+// which may be before the global is defined (a function using a global
+// declared further down), the slot just stays undefined until then.
+// Names are only looked at to resolve them and to report an undefined one.
+class Globals
+{
+    public:
+        // the slot for name, a new undefined one if name hasn't been seen before
+        int resolve(LoxString* name);
+        // forgets the slots from count on, none of them can have been defined yet
+        void truncate(int count);
+
+        bool isDefined(int slot) const { return slots[slot].defined; }
+        Value& value(int slot) { return slots[slot].value; }
+        void define(int slot, Value value) { slots[slot].value = value; slots[slot].defined = true; }
+        LoxString* name(int slot) const { return slots[slot].name; }
+        int count() const { return static_cast<int>(slots.size()); }
+
+        // visits the names and values
+        void trace(Tracer& tracer);
+
+    private:
+        struct Slot
+        {
+            Value value;
+            bool defined = false;
+            LoxString* name;
+        };
+
+        std::vector<Slot> slots;
+        Table indices; // name to slot number
+};
+#endif
@@ -0,0 +1,369 @@
+#include "heap.h"
+#include <algorithm>
+#include <cstdio>
+
+// checking the clock costs about as much as tracing a small object, so it's only done this often
+static constexpr int WORK_PER_CLOCK_CHECK = 64;
+
+// the nursery is allocated by the first young allocation, scripts that never make one don't pay for it
+Heap::Heap(): nurseryTop(nullptr), nurseryEnd(nullptr), nurseryLimit(nullptr) {}
+
+Heap::~Heap()
+{
+    for (std::byte* at = nursery.get(); at < nurseryTop; )
+    {
+        Object* object = reinterpret_cast<Object*>(at);
+        at += object->size;
+        object->~Object();
+    }
+
+    for (Object* list : {objects, sweepList})
+    {
+        while (list)
+        {
+            Object* next = list->next;
+            list->~Object();
+            ::operator delete(list);
+            list = next;
+        }
+    }
+}
+
+LoxString* Heap::makeString(std::string_view chars)
+{
+    std::uint32_t hash = LoxString::hashString(chars);
+    if (LoxString* interned = internedString(chars, hash)) return interned;
+
+    LoxString* string = allocateString(chars.size());
+    chars.copy(string->chars(), chars.size());
+    return intern(string);
+}
+
+LoxString* Heap::allocateString(std::size_t length)
+{
+    std::size_t size = roundUp(LoxString::allocationSize(length));
+    bool young = canAllocateYoung(size);
+    void* memory = young ? reserveYoung(size) : ::operator new(size);
+    LoxString* string = new (memory) LoxString(static_cast<std::uint32_t>(length));
+    track(string, size, young);
+    return string;
+}
+
+LoxString* Heap::intern(LoxString* string)
+{
+    string->hash = LoxString::hashString(string->view());
+    // the new string is garbage straight away if there's one already
+    if (LoxString* interned = internedString(string->view(), string->hash)) return interned;
+
+    strings.set(string, Value::nil());
+    if (string->young) youngStrings.push_back(string);
+    return string;
+}
+
+LoxString* Heap::internedString(std::string_view chars, std::uint32_t hash)
+{
+    LoxString* interned = strings.findString(chars, hash);
+    // handing out a string nothing may have referenced at the start of marking, it
+    // has to survive like a newly allocated one would
+    if (interned && phase == Phase::MARK) shade(interned);
+    return interned;
+}
+
+void Heap::setRoots(RootSource* source)
+{
+    roots = source;
+}
+
+void Heap::setPacing(double growthFactor, int pauseBudgetMicros)
+{
+    this->growthFactor = growthFactor;
+    this->pauseBudgetMicros = pauseBudgetMicros;
+}
+
+void Heap::track(Object* object, std::size_t size, bool young)
+{
+    object->size = static_cast<std::uint32_t>(size);
+    object->young = young;
+    if (young) return;
+
+    // born black while marking, a new object wasn't part of the snapshot being traced
+    object->marked = phase == Phase::MARK;
+    object->next = objects;
+    objects = object;
+    bytesAllocated += size;
+
+    #ifdef LOX_GC_STRESS
+    // a step on every old allocation, to shake out missing roots and barriers
+    if (pauseDepth == 0)
+    #else
+    if (bytesAllocated >= nextStep && pauseDepth == 0)
+    #endif
+    {
+        // nothing references the new object yet, so it's a root for the duration
+        newest = object;
+        step();
+        newest = nullptr;
+    }
+}
+
+void Heap::makeYoungRoom(std::size_t size)
+{
+    if (nursery == nullptr)
+    {
+        nursery.reset(new std::byte[NURSERY_SIZE]);
+        nurseryTop = nursery.get();
+        nurseryLimit = nurseryTop + nurserySize;
+        nurseryEnd = nurseryLimit;
+        return;
+    }
+
+    // the step a minor collection put off, the pause before this one was the collection's
+    if (stepDue) step();
+    nurseryEnd = nurseryLimit;
+    if (size <= static_cast<std::size_t>(nurseryEnd - nurseryTop)) return;
+
+    minorCollect();
+    // promoting grows the old space as much as allocating there does
+    if (bytesAllocated >= nextStep)
+    {
+        stepDue = true;
+        nurseryEnd = nurseryTop + STEP_DELAY_BYTES;
+    }
+}
+
+void Heap::minorCollect()
+{
+    std::size_t promotedBefore = gcStats.bytesPromoted;
+    // nothing young means nothing remembered either
+    if (nurseryTop == nursery.get()) return;
+    auto start = std::chrono::steady_clock::now();
+
+    Evacuator evacuator(*this);
+    if (roots) roots->traceRoots(evacuator);
+    if (newest) newest->trace(evacuator);
+    for (Object* object : remembered)
+    {
+        object->remembered = false;
+        object->trace(evacuator);
+    }
+    remembered.clear();
+    // tracing what was promoted can promote more
+    while (!promoted.empty())
+    {
+        Object* object = promoted.back();
+        promoted.pop_back();
+        object->trace(evacuator);
+    }
+
+    // the intern set is weak, it follows the strings that moved and forgets the rest
+    for (LoxString* string : youngStrings)
+    {
+        if (string->forwarded)
+        {
+            strings.replaceKey(string, static_cast<LoxString*>(string->next));
+        }
+        else
+        {
+            strings.remove(string);
+        }
+    }
+    youngStrings.clear();
+
+    // whatever moved left an emptied shell behind, dead or not everything here gets destroyed
+    for (std::byte* at = nursery.get(); at < nurseryTop; )
+    {
+        Object* object = reinterpret_cast<Object*>(at);
+        at += object->size;
+        if (object->type != ObjectType::STRING) object->~Object();
+    }
+    nurseryTop = nursery.get();
+
+    gcStats.minorCollections++;
+    resizeNursery(recordPause(start), gcStats.bytesPromoted - promotedBefore);
+}
+
+// the pause is mostly copying survivors, so it's only as long as the nursery is big. It grows
+// while pauses are short, but never past what copying all of it would take a whole budget for,
+// or a program that goes from making garbage to keeping everything would pay for the lot at once
+void Heap::resizeNursery(double pauseMicros, std::size_t promotedBytes)
+{
+    if (promotedBytes >= MIN_NURSERY_SIZE / 2)
+    {
+        double perByte = pauseMicros / promotedBytes;
+        copyMicrosPerByte = copyMicrosPerByte == 0 ? perByte : (copyMicrosPerByte + perByte) / 2;
+    }
+
+    if (pauseMicros > pauseBudgetMicros && nurserySize > MIN_NURSERY_SIZE)
+    {
+        nurserySize /= 2;
+    }
+    else if (pauseMicros < pauseBudgetMicros / 4.0 && nurserySize < NURSERY_SIZE &&
+             nurserySize * 2 * copyMicrosPerByte <= pauseBudgetMicros)
+    {
+        nurserySize *= 2;
+    }
+    nurseryLimit = nursery.get() + nurserySize;
+    nurseryEnd = nurseryLimit;
+}
+
+Object* Heap::promote(Object* object)
+{
+    if (object->forwarded) return object->next;
+
+    std::uint32_t size = object->size;
+    Object* copy = object->relocate(::operator new(size));
+    copy->size = size;
+    copy->marked = phase == Phase::MARK;
+    copy->next = objects;
+    objects = copy;
+    bytesAllocated += size;
+    gcStats.bytesPromoted += size;
+
+    object->forwarded = true;
+    object->next = copy;
+    promoted.push_back(copy);
+    return copy;
+}
+
+void Heap::step()
+{
+    auto stepStart = std::chrono::steady_clock::now();
+    stepDue = false;
+
+    // starting a cycle empties the nursery, that's this step's pause and marking waits for the next
+    if (phase == Phase::IDLE)
+    {
+        startCycle();
+    }
+    else
+    {
+        if (phase == Phase::MARK && markSome(stepStart)) finishMarking();
+        if (phase == Phase::SWEEP && sweepSome(stepStart)) finishCycle();
+    }
+
+    if (phase != Phase::IDLE) nextStep = bytesAllocated + STEP_BYTES;
+
+    gcStats.steps++;
+    recordPause(stepStart);
+}
+
+void Heap::startCycle()
+{
+    // with the nursery empty the snapshot is entirely old objects, and the remembered set is
+    // empty too, so none of its objects can be swept before the next minor collection
+    minorCollect();
+    phase = Phase::MARK;
+
+    // the roots are shaded in one go, the only part of marking that can't be split up
+    Marker marker(*this);
+    if (roots) roots->traceRoots(marker);
+    shade(newest);
+}
+
+bool Heap::markSome(std::chrono::steady_clock::time_point stepStart)
+{
+    Marker marker(*this);
+    for (int work = 1; !gray.empty(); work++)
+    {
+        Object* object = gray.back();
+        gray.pop_back();
+        object->trace(marker);
+
+        if (work % WORK_PER_CLOCK_CHECK == 0 && outOfTime(stepStart)) return gray.empty();
+    }
+    return true;
+}
+
+void Heap::finishMarking()
+{
+    // everything unmarked now is garbage, the strings among it mustn't be found by makeString
+    strings.removeUnmarked();
+
+    // objects allocated from here on go on a fresh list, sweeping only looks at the old one
+    sweepList = objects;
+    objects = nullptr;
+    phase = Phase::SWEEP;
+}
+
+bool Heap::sweepSome(std::chrono::steady_clock::time_point stepStart)
+{
+    for (int work = 1; sweepList; work++)
+    {
+        Object* object = sweepList;
+        sweepList = object->next;
+
+        if (object->marked)
+        {
+            object->marked = false;
+            object->next = objects;
+            objects = object;
+        }
+        else
+        {
+            freeObject(object);
+        }
+
+        if (work % WORK_PER_CLOCK_CHECK == 0 && outOfTime(stepStart)) return sweepList == nullptr;
+    }
+    return true;
+}
+
+void Heap::finishCycle()
+{
+    phase = Phase::IDLE;
+    gcStats.cycles++;
+    nextStep = std::max(static_cast<std::size_t>(bytesAllocated * growthFactor), MIN_THRESHOLD);
+}
+
+bool Heap::outOfTime(std::chrono::steady_clock::time_point stepStart) const
+{
+    return std::chrono::steady_clock::now() - stepStart >= std::chrono::microseconds(pauseBudgetMicros);
+}
+
+double Heap::recordPause(std::chrono::steady_clock::time_point start)
+{
+    double pause = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    gcStats.totalPauseMicros += pause;
+    gcStats.maxPauseMicros = std::max(gcStats.maxPauseMicros, pause);
+    auto bucket = std::upper_bound(GcStats::PAUSE_BUCKETS.begin(), GcStats::PAUSE_BUCKETS.end(), pause);
+    gcStats.pauses[bucket - GcStats::PAUSE_BUCKETS.begin()]++;
+    return pause;
+}
+
+void Heap::freeObject(Object* object)
+{
+    bytesAllocated -= object->size;
+    gcStats.objectsFreed++;
+    gcStats.bytesFreed += object->size;
+    object->~Object();
+    ::operator delete(object);
+}
+
+std::string GcStats::report() const
+{
+    char line[128];
+    std::string out;
+
+    std::snprintf(line, sizeof(line), "gc: %d cycles, %ld steps, %.3f ms paused in total, longest pause %.1f us\n",
+                  cycles, steps, totalPauseMicros / 1000, maxPauseMicros);
+    out += line;
+    std::snprintf(line, sizeof(line), "gc: %zu objects (%.1f KB) freed\n", objectsFreed, bytesFreed / 1024.0);
+    out += line;
+    std::snprintf(line, sizeof(line), "gc: %ld minor collections, %.1f KB promoted\n", minorCollections, bytesPromoted / 1024.0);
+    out += line;
+
+    out += "gc: pause histogram\n";
+    for (std::size_t i = 0; i < pauses.size(); i++)
+    {
+        if (i < PAUSE_BUCKETS.size())
+        {
+            std::snprintf(line, sizeof(line), "  < %5d us  %ld\n", PAUSE_BUCKETS[i], pauses[i]);
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "  >=%5d us  %ld\n", PAUSE_BUCKETS.back(), pauses[i]);
+        }
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,279 @@
+#ifndef HEAP_H
+#define HEAP_H
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "lox/types/object.h"
+#include "lox/types/value.h"
+#include "lox/types/lox_string.h"
+#include "lox/types/lox_instance.h"
+#include "lox/types/lox_bound_method.h"
+#include "lox/types/lox_closure.h"
+#include "lox/types/lox_upvalue.h"
+#include "table.h"
+
+// implemented by whatever holds references the heap can't find by itself (the VM's stack and globals)
+class RootSource
+{
+    public:
+        virtual void traceRoots(Tracer& tracer) = 0;
+
+    protected:
+        ~RootSource() = default;
+};
+
+struct GcStats
+{
+    // upper bounds of the pause histogram buckets in microseconds, the last bucket is everything longer
+    static constexpr std::array<int, 9> PAUSE_BUCKETS{10, 25, 50, 100, 250, 500, 1000, 2000, 5000};
+
+    int cycles = 0;
+    long steps = 0;
+    long minorCollections = 0;
+    double totalPauseMicros = 0;
+    double maxPauseMicros = 0;
+    std::size_t objectsFreed = 0;
+    std::size_t bytesFreed = 0;
+    std::size_t bytesPromoted = 0;
+    // major steps and minor collections both count as pauses
+    std::array<long, PAUSE_BUCKETS.size() + 1> pauses{};
+
+    std::string report() const;
+};
+
+// Owns every Object the compiler and VM create and frees the ones that are
+// no longer reachable. It's generational:
+// - strings, instances, bound methods, closures and upvalues are bump
+//   allocated from the nursery. When it fills up a minor collection copies
+//   whatever is still reachable into the old space and starts over, so a
+//   short lived object costs a pointer bump and is never freed on its own
+// - a minor collection can't stop halfway, so its pause is bounded by the
+//   nursery's size instead: the part in use shrinks while minor pauses go
+//   over pauseBudgetMicros and grows back while they're well under it
+// - functions, classes, shapes and natives live as long as the script and
+//   go straight to the old space, as does everything allocated while
+//   collection is paused (which is how methods' closures get there)
+// - the old space is collected by an incremental mark-sweep, a cycle starts
+//   once it has grown by growthFactor since the last one finished, after
+//   that every STEP_BYTES allocated there runs one step of marking or
+//   sweeping for at most pauseBudgetMicros. A step that falls due while a
+//   minor collection promotes waits for a little more young allocation,
+//   so the two pauses never add up
+// - marking is snapshot at the beginning: the nursery is emptied and the
+//   roots shaded when a cycle starts, new objects are born black, and
+//   writeBarrier shades the value a reference is about to lose
+// - writeBarrier also remembers old objects given a reference to a young
+//   one, they're roots of the next minor collection along with the VM's
+// - the intern set is weak, strings nothing else references are dropped
+//   from it before they're freed
+// A minor collection moves objects, so nothing young may be held across an
+// allocation unless a root can see it. In particular don't pass a young
+// object to allocate, set it on the new object afterwards.
+// Define LOX_NO_NURSERY to allocate everything in the old space.
+class Heap
+{
+    public:
+        // keeps collections from running while it's alive, for code holding new
+        // objects that no root can see yet (the compiler)
+        class CollectionPause
+        {
+            public:
+                explicit CollectionPause(Heap& heap): heap(heap) { heap.pauseDepth++; }
+                ~CollectionPause() { heap.pauseDepth--; }
+
+                CollectionPause(const CollectionPause&) = delete;
+                CollectionPause& operator=(const CollectionPause&) = delete;
+
+            private:
+                Heap& heap;
+        };
+
+        Heap();
+        ~Heap();
+
+        Heap(const Heap&) = delete;
+        Heap& operator=(const Heap&) = delete;
+
+        template <typename T, typename... Args>
+        T* allocate(Args&&... args)
+        {
+            return allocateSized<T>(sizeof(T), std::forward<Args>(args)...);
+        }
+
+        // for objects that keep data straight after themselves, size covers both
+        template <typename T, typename... Args>
+        T* allocateSized(std::size_t size, Args&&... args)
+        {
+            static_assert(!std::is_same_v<T, LoxString>, "strings come from makeString or allocateString");
+            constexpr bool nurseryType = std::is_same_v<T, LoxInstance> || std::is_same_v<T, LoxBoundMethod> ||
+                                          std::is_same_v<T, LoxClosure> || std::is_same_v<T, LoxUpvalue>;
+            size = roundUp(size);
+
+            // a minor collection has to happen before the new object is built from args, not after
+            bool young = nurseryType && canAllocateYoung(size);
+            void* memory = young ? reserveYoung(size) : ::operator new(size);
+            T* object = new (memory) T(std::forward<Args>(args)...);
+            track(object, size, young);
+            return object;
+        }
+
+        // the interned string with these characters
+        LoxString* makeString(std::string_view chars);
+        // a string of length characters for the caller to fill in and pass to intern,
+        // this can collect so only read what the characters come from afterwards
+        LoxString* allocateString(std::size_t length);
+        // string, or the one already interned with the same characters
+        LoxString* intern(LoxString* string);
+
+        void setRoots(RootSource* source);
+        void setPacing(double growthFactor, int pauseBudgetMicros);
+
+        // call when owner (nullptr for a global) is about to replace the reference old with value
+        void writeBarrier(Object* owner, Value old, Value value)
+        {
+            if (phase == Phase::MARK && old.isObject()) shade(old.asObject());
+            if (owner && !owner->young && !owner->remembered && value.isObject() && value.asObject()->young)
+            {
+                owner->remembered = true;
+                remembered.push_back(owner);
+            }
+        }
+
+        // for an owner that took references wholesale (Table::addAll), cheaper than a barrier for each
+        void remember(Object* owner)
+        {
+            if (owner->young || owner->remembered) return;
+            owner->remembered = true;
+            remembered.push_back(owner);
+        }
+
+        std::size_t allocated() const { return bytesAllocated; }
+        const GcStats& stats() const { return gcStats; }
+
+    private:
+        enum class Phase { IDLE, MARK, SWEEP };
+
+        // shades what it visits, so tracing an object gray makes it black
+        class Marker: public Tracer
+        {
+            public:
+                explicit Marker(Heap& heap): heap(heap) {}
+                virtual void visit(Object*& object) override { heap.shade(object); }
+                virtual void visit(Value& value) override { if (value.isObject()) heap.shade(value.asObject()); }
+
+            private:
+                Heap& heap;
+        };
+
+        // copies the young objects it visits into the old space and points the reference at the copy
+        class Evacuator: public Tracer
+        {
+            public:
+                explicit Evacuator(Heap& heap): heap(heap) {}
+                virtual void visit(Object*& object) override
+                {
+                    if (object && object->young) object = heap.promote(object);
+                }
+                virtual void visit(Value& value) override
+                {
+                    if (value.isObject() && value.asObject()->young) value = Value::object(heap.promote(value.asObject()));
+                }
+
+            private:
+                Heap& heap;
+        };
+
+        static constexpr std::size_t STEP_BYTES = 64 * 1024;
+        static constexpr std::size_t MIN_THRESHOLD = 1024 * 1024;
+        // the most of the nursery in use at once, and the least
+        static constexpr std::size_t NURSERY_SIZE = 1024 * 1024;
+        static constexpr std::size_t MIN_NURSERY_SIZE = 64 * 1024;
+        // young allocation between a minor collection and a step it made due
+        static constexpr std::size_t STEP_DELAY_BYTES = 16 * 1024;
+        // copying anything bigger out again would cost more than allocating it old
+        static constexpr std::size_t MAX_YOUNG_SIZE = 4096;
+
+        static constexpr std::size_t roundUp(std::size_t size) { return (size + 7) & ~std::size_t(7); }
+
+        bool canAllocateYoung(std::size_t size) const
+        {
+            #ifdef LOX_NO_NURSERY
+            return false;
+            #else
+            return pauseDepth == 0 && size <= MAX_YOUNG_SIZE;
+            #endif
+        }
+
+        void* reserveYoung(std::size_t size)
+        {
+            #ifdef LOX_GC_STRESS
+            // a minor collection on every young allocation, to shake out missing roots and barriers
+            minorCollect();
+            #endif
+            if (size > static_cast<std::size_t>(nurseryEnd - nurseryTop)) makeYoungRoom(size);
+            void* memory = nurseryTop;
+            nurseryTop += size;
+            return memory;
+        }
+
+        void track(Object* object, std::size_t size, bool young);
+        LoxString* internedString(std::string_view chars, std::uint32_t hash);
+        void shade(Object* object)
+        {
+            // young objects are treated as black, they're marked if and when they're promoted
+            if (object == nullptr || object->marked || object->young) return;
+            object->marked = true;
+            gray.push_back(object);
+        }
+
+        void makeYoungRoom(std::size_t size);
+        void minorCollect();
+        void resizeNursery(double pauseMicros, std::size_t promotedBytes);
+        Object* promote(Object* object);
+        void step();
+        void startCycle();
+        // each returns true once its phase is done, false if the step ran out of time first
+        bool markSome(std::chrono::steady_clock::time_point stepStart);
+        void finishMarking();
+        bool sweepSome(std::chrono::steady_clock::time_point stepStart);
+        void finishCycle();
+        bool outOfTime(std::chrono::steady_clock::time_point stepStart) const;
+        // returns the pause in microseconds
+        double recordPause(std::chrono::steady_clock::time_point start);
+        void freeObject(Object* object);
+
+        std::unique_ptr<std::byte[]> nursery;
+        std::byte* nurseryTop;
+        std::byte* nurseryEnd; // where allocation stops to collect, or to run a step that's due
+        std::byte* nurseryLimit; // the end of the part in use
+        std::size_t nurserySize = MIN_NURSERY_SIZE;
+        double copyMicrosPerByte = 0; // how long promoting takes, 0 until it's been seen
+        bool stepDue = false;
+        std::vector<LoxString*> youngStrings; // the interned strings still in the nursery
+        std::vector<Object*> remembered;
+        std::vector<Object*> promoted; // copied by this minor collection but not traced yet
+        Object* newest = nullptr; // an old object a step is running for, before its caller can root it
+
+        Object* objects = nullptr; // the old space
+        Object* sweepList = nullptr; // not yet swept this cycle, survivors go back to objects
+        std::vector<Object*> gray;
+        Table strings; // keys only, the values are all nil
+
+        RootSource* roots = nullptr;
+        Phase phase = Phase::IDLE;
+        int pauseDepth = 0;
+        std::size_t bytesAllocated = 0; // in the old space
+        std::size_t nextStep = MIN_THRESHOLD;
+        double growthFactor = 2.0;
+        int pauseBudgetMicros = 500;
+        GcStats gcStats;
+};
+#endif
@@ -0,0 +1,41 @@
+#include "inline_cache.h"
+#include <cstdio>
+#include "lox/types/lox_closure.h"
+#include "lox/types/shape.h"
+
+void InlineCache::remember(const Entry& entry)
+{
+    if (count < MAX_ENTRIES)
+    {
+        entries[count++] = entry;
+    }
+    else
+    {
+        megamorphic = true;
+    }
+}
+
+void InlineCache::trace(Tracer& tracer)
+{
+    for (int i = 0; i < count; i++)
+    {
+        tracer.visit(entries[i].shape);
+        tracer.visit(entries[i].method);
+        tracer.visit(entries[i].next);
+    }
+}
+
+static std::string countsLine(const char* name, const IcStats::Counts& counts)
+{
+    long total = counts.hits + counts.misses + counts.megamorphic;
+    double rate = total == 0 ? 0 : 100.0 * counts.hits / total;
+    char line[128];
+    std::snprintf(line, sizeof(line), "ic: %-6s %5.1f%% hits (%ld hits, %ld misses, %ld megamorphic)\n",
+                  name, rate, counts.hits, counts.misses, counts.megamorphic);
+    return line;
+}
+
+std::string IcStats::report() const
+{
+    return countsLine("get", get) + countsLine("set", set) + countsLine("invoke", invoke);
+}
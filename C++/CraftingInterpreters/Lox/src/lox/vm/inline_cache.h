@@ -0,0 +1,73 @@
+#ifndef INLINE_CACHE_H
+#define INLINE_CACHE_H
+#include <array>
+#include <cstdint>
+#include <string>
+
+class Object;
+class Tracer;
+class Shape;
+class LoxClosure;
+
+// What a property access or invoke found for the last few shapes of
+// receiver it saw, every such instruction has one in its chunk. A shape
+// fixes both the class and where each field is, so a hit needs no checks.
+// - a field is remembered as its slot
+// - a method is remembered as the function, the shape not having a field
+//   of that name is what made it the method
+// - adding a field is remembered as the shape it moves the instance to
+// - once a fifth shape turns up the site is megamorphic and stops looking
+//   at the cache, which keeps what it has so nothing is lost mid-cycle
+class InlineCache
+{
+    public:
+        static constexpr int MAX_ENTRIES = 4;
+
+        struct Entry
+        {
+            Shape* shape;
+            LoxClosure* method; // nullptr for a field
+            Shape* next; // the instance's shape once the field is added, nullptr if it already has it
+            int slot;
+        };
+
+        // the entry for shape, nullptr if there isn't one
+        Entry* lookup(Shape* shape)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (entries[i].shape == shape) return &entries[i];
+            }
+            return nullptr;
+        }
+
+        // after a miss
+        void remember(const Entry& entry);
+        bool isMegamorphic() const { return megamorphic; }
+
+        // what's cached is kept alive, a freed shape's address could be handed out again to a new one
+        void trace(Tracer& tracer);
+
+    private:
+        std::array<Entry, MAX_ENTRIES> entries;
+        std::uint8_t count = 0;
+        bool megamorphic = false;
+};
+
+// how the caches did, shown with --ic-stats, only counted when built with LOX_IC_STATS
+struct IcStats
+{
+    struct Counts
+    {
+        long hits = 0;
+        long misses = 0;
+        long megamorphic = 0; // accesses at megamorphic sites, which don't count as misses
+    };
+
+    Counts get;
+    Counts set;
+    Counts invoke;
+
+    std::string report() const;
+};
+#endif
@@ -0,0 +1,151 @@
+#include "peephole.h"
+#include <array>
+#include <cstddef>
+
+namespace
+{
+    struct Pattern
+    {
+        std::array<OpCode, 3> ops;
+        int length;
+        OpCode fused; // takes the operands of ops, in order
+    };
+
+    // longest first, the first one matching wins
+    const Pattern PATTERNS[] = {
+        {{OpCode::GET_LOCAL, OpCode::CONSTANT, OpCode::ADD}, 3, OpCode::ADD_LOCAL_CONSTANT},
+        {{OpCode::GET_LOCAL, OpCode::CONSTANT, OpCode::SUBTRACT}, 3, OpCode::SUBTRACT_LOCAL_CONSTANT},
+        {{OpCode::LESS, OpCode::JUMP_IF_FALSE, OpCode::POP}, 3, OpCode::LESS_JUMP_IF_FALSE},
+        {{OpCode::JUMP_IF_FALSE, OpCode::POP}, 2, OpCode::JUMP_IF_FALSE_POP},
+        {{OpCode::GET_LOCAL, OpCode::CONSTANT}, 2, OpCode::GET_LOCAL_CONSTANT},
+        {{OpCode::GET_LOCAL, OpCode::GET_PROPERTY}, 2, OpCode::GET_LOCAL_PROPERTY},
+        {{OpCode::SET_LOCAL, OpCode::POP}, 2, OpCode::SET_LOCAL_POP},
+    };
+
+    // a jump operand in the new code and the instruction in the old code it has to reach
+    struct Jump
+    {
+        std::size_t operand;
+        std::size_t target;
+        bool backwards;
+    };
+
+    int readShort(const std::vector<std::uint8_t>& code, std::size_t offset)
+    {
+        return (code[offset] << 8) | code[offset + 1];
+    }
+
+    bool isJump(OpCode op)
+    {
+        return op == OpCode::JUMP || op == OpCode::JUMP_IF_FALSE || op == OpCode::LOOP;
+    }
+
+    std::size_t jumpTarget(const std::vector<std::uint8_t>& code, std::size_t offset)
+    {
+        int distance = readShort(code, offset + 1);
+        return static_cast<OpCode>(code[offset]) == OpCode::LOOP ? offset + 3 - distance : offset + 3 + distance;
+    }
+}
+
+int fusedInstructions(OpCode op)
+{
+    for (const Pattern& pattern : PATTERNS)
+    {
+        if (pattern.fused == op) return pattern.length;
+    }
+    return 1;
+}
+
+void fuseSuperinstructions(Chunk& chunk)
+{
+    #ifdef LOX_NO_SUPERINSTRUCTIONS
+    return;
+    #endif
+
+    const std::vector<std::uint8_t>& code = chunk.code;
+    std::vector<int> lines = chunk.expandLines();
+
+    std::vector<std::size_t> starts;
+    std::vector<bool> isTarget(code.size() + 1, false);
+    for (std::size_t offset = 0; offset < code.size(); offset += chunk.instructionLength(static_cast<int>(offset)))
+    {
+        starts.push_back(offset);
+        OpCode op = static_cast<OpCode>(code[offset]);
+        if (!isJump(op)) continue;
+
+        std::size_t target = jumpTarget(code, offset);
+        isTarget[target] = true;
+        // where a fused JUMP_IF_FALSE_POP lands instead
+        if (op == OpCode::JUMP_IF_FALSE && static_cast<OpCode>(code[target]) == OpCode::POP) isTarget[target + 1] = true;
+    }
+
+    std::vector<std::uint8_t> fusedCode;
+    std::vector<int> fusedLines;
+    std::vector<std::size_t> newOffsets(code.size() + 1, 0);
+    std::vector<Jump> jumps;
+
+    auto matches = [&](const Pattern& pattern, std::size_t first) {
+        if (first + pattern.length > starts.size()) return false;
+        for (int i = 0; i < pattern.length; i++)
+        {
+            std::size_t offset = starts[first + i];
+            if (static_cast<OpCode>(code[offset]) != pattern.ops[i]) return false;
+            if (i > 0 && (isTarget[offset] || lines[offset] != lines[starts[first]])) return false;
+            if (pattern.ops[i] == OpCode::JUMP_IF_FALSE && static_cast<OpCode>(code[jumpTarget(code, offset)]) != OpCode::POP) return false;
+        }
+        return true;
+    };
+
+    for (std::size_t i = 0; i < starts.size(); )
+    {
+        const Pattern* fused = nullptr;
+        for (const Pattern& pattern : PATTERNS)
+        {
+            if (matches(pattern, i))
+            {
+                fused = &pattern;
+                break;
+            }
+        }
+        int count = fused ? fused->length : 1;
+
+        std::size_t groupStart = fusedCode.size();
+        int line = lines[starts[i]];
+        if (fused)
+        {
+            fusedCode.push_back(static_cast<std::uint8_t>(fused->fused));
+            fusedLines.push_back(line);
+        }
+
+        // operands are copied as they are, jump offsets are filled in once every instruction has moved
+        for (int part = 0; part < count; part++)
+        {
+            std::size_t offset = starts[i + part];
+            OpCode op = static_cast<OpCode>(code[offset]);
+            newOffsets[offset] = groupStart;
+            if (isJump(op))
+            {
+                std::size_t target = jumpTarget(code, offset);
+                jumps.push_back(Jump{fusedCode.size() + (fused ? 0 : 1), fused ? target + 1 : target, op == OpCode::LOOP});
+            }
+
+            std::size_t begin = fused ? offset + 1 : offset;
+            std::size_t end = offset + chunk.instructionLength(static_cast<int>(offset));
+            fusedCode.insert(fusedCode.end(), code.begin() + begin, code.begin() + end);
+            fusedLines.insert(fusedLines.end(), end - begin, line);
+        }
+        i += count;
+    }
+    newOffsets[code.size()] = fusedCode.size();
+
+    for (const Jump& jump : jumps)
+    {
+        std::size_t after = jump.operand + 2;
+        std::size_t target = newOffsets[jump.target];
+        std::size_t distance = jump.backwards ? after - target : target - after;
+        fusedCode[jump.operand] = static_cast<std::uint8_t>((distance >> 8) & 0xff);
+        fusedCode[jump.operand + 1] = static_cast<std::uint8_t>(distance & 0xff);
+    }
+
+    chunk.replaceCode(fusedCode, fusedLines);
+}
@@ -0,0 +1,18 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+#include "chunk.h"
+
+// Rewrites a function's finished chunk, fusing the sequences that came up
+// most in the dispatch profile of bench/*.lox into the superinstructions at
+// the end of LOX_OPCODES, so each costs one dispatch instead of two or three.
+// - nothing is fused across a jump target, or across lines so a runtime
+//   error in a fused instruction still reports the right one
+// - JUMP_IF_FALSE, POP is only fused when the jump lands on a POP, the
+//   fused jump has already popped so it lands just after it
+// - jump offsets are worked out again for the shorter code
+// Define LOX_NO_SUPERINSTRUCTIONS to keep chunks as the compiler made them.
+void fuseSuperinstructions(Chunk& chunk);
+
+// how many of the compiler's instructions op stands for, 1 unless it's a superinstruction
+int fusedInstructions(OpCode op);
+#endif
@@ -0,0 +1,133 @@
+#include "table.h"
+
+Value* Table::find(LoxString* key)
+{
+    if (count == 0) return nullptr;
+
+    Entry* entry = findEntry(key);
+    return entry->key ? &entry->value : nullptr;
+}
+
+bool Table::set(LoxString* key, Value value)
+{
+    // kept at most 3/4 full, including tombstones
+    if ((count + 1) * 4 > static_cast<int>(entries.size()) * 3) grow();
+
+    Entry* entry = findEntry(key);
+    bool isNewKey = entry->key == nullptr;
+    // reusing a tombstone doesn't change the count, it was already counted
+    if (isNewKey && entry->value.isNil()) count++;
+
+    entry->key = key;
+    entry->value = value;
+    return isNewKey;
+}
+
+bool Table::remove(LoxString* key)
+{
+    if (count == 0) return false;
+
+    Entry* entry = findEntry(key);
+    if (entry->key == nullptr) return false;
+
+    entry->key = nullptr;
+    entry->value = Value::boolean(true);
+    return true;
+}
+
+void Table::replaceKey(LoxString* key, LoxString* replacement)
+{
+    if (count == 0) return;
+
+    Entry* entry = findEntry(key);
+    if (entry->key == key) entry->key = replacement;
+}
+
+void Table::addAll(const Table& from)
+{
+    for (const Entry& entry : from.entries)
+    {
+        if (entry.key) set(entry.key, entry.value);
+    }
+}
+
+LoxString* Table::findString(std::string_view chars, std::uint32_t hash) const
+{
+    if (count == 0) return nullptr;
+
+    std::size_t mask = entries.size() - 1;
+    for (std::size_t index = hash & mask; ; index = (index + 1) & mask)
+    {
+        const Entry& entry = entries[index];
+        if (entry.key == nullptr)
+        {
+            if (entry.value.isNil()) return nullptr; // empty, tombstones are skipped
+        }
+        else if (entry.key->hash == hash && entry.key->view() == chars)
+        {
+            return entry.key;
+        }
+    }
+}
+
+// the entry holding key, or else where it would go (the first tombstone passed, if any)
+Table::Entry* Table::findEntry(LoxString* key)
+{
+    return const_cast<Entry*>(static_cast<const Table*>(this)->findEntry(key));
+}
+
+const Table::Entry* Table::findEntry(LoxString* key) const
+{
+    std::size_t mask = entries.size() - 1;
+    const Entry* tombstone = nullptr;
+
+    for (std::size_t index = key->hash & mask; ; index = (index + 1) & mask)
+    {
+        const Entry& entry = entries[index];
+        if (entry.key == key) return &entry;
+
+        if (entry.key == nullptr)
+        {
+            if (entry.value.isNil()) return tombstone ? tombstone : &entry;
+            if (tombstone == nullptr) tombstone = &entry;
+        }
+    }
+}
+
+void Table::grow()
+{
+    std::vector<Entry> old = std::move(entries);
+    entries.assign(old.empty() ? MIN_CAPACITY : old.size() * 2, Entry{});
+
+    // tombstones aren't carried over
+    count = 0;
+    for (const Entry& entry : old)
+    {
+        if (entry.key == nullptr) continue;
+        *findEntry(entry.key) = entry;
+        count++;
+    }
+}
+
+void Table::trace(Tracer& tracer)
+{
+    for (Entry& entry : entries)
+    {
+        if (entry.key == nullptr) continue;
+        tracer.visit(entry.key);
+        tracer.visit(entry.value);
+    }
+}
+
+void Table::removeUnmarked()
+{
+    for (Entry& entry : entries)
+    {
+        // strings in the nursery aren't marked, minor collections look after those
+        if (entry.key && !entry.key->marked && !entry.key->young)
+        {
+            entry.key = nullptr;
+            entry.value = Value::boolean(true);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef TABLE_H
+#define TABLE_H
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "lox/types/value.h"
+#include "lox/types/lox_string.h"
+
+// Open addressing hash table keyed by interned strings, used for methods,
+// shape transitions and the global slots' names, and (with nil values) as
+// the Heap's intern set.
+// - keys are compared by pointer, only findString looks at characters
+// - linear probing over a power of two capacity, removed entries leave a
+//   tombstone so probe sequences running through them aren't cut short
+class Table
+{
+    public:
+        // nullptr if key isn't in the table, the pointer is invalidated by the next set
+        Value* find(LoxString* key);
+        // returns true if key wasn't already in the table
+        bool set(LoxString* key, Value value);
+        bool remove(LoxString* key);
+        void addAll(const Table& from);
+        // for a key the Heap has moved, replacement must have the same hash
+        void replaceKey(LoxString* key, LoxString* replacement);
+        // visits every key and value
+        void trace(Tracer& tracer);
+        // drops the entries whose key the collector didn't mark, for the weak intern set
+        void removeUnmarked();
+
+        // the interned string with these characters, if there is one
+        LoxString* findString(std::string_view chars, std::uint32_t hash) const;
+
+    private:
+        struct Entry
+        {
+            LoxString* key = nullptr; // nullptr with a nil value is empty, anything else a tombstone
+            Value value;
+        };
+
+        static constexpr int MIN_CAPACITY = 8;
+
+        const Entry* findEntry(LoxString* key) const;
+        Entry* findEntry(LoxString* key);
+        void grow();
+
+        std::vector<Entry> entries;
+        int count = 0; // live entries plus tombstones
+};
+#endif
@@ -0,0 +1,889 @@
+#include "vm.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <utility>
+#include "compiler.h"
+#include "lox/types/lox_string.h"
+#include "lox/types/lox_instance.h"
+#include "lox/types/lox_bound_method.h"
+
+#if defined(__GNUC__) && !defined(LOX_NO_COMPUTED_GOTO)
+#define LOX_COMPUTED_GOTO
+#endif
+
+// property accesses are too frequent to count in every build
+#ifdef LOX_IC_STATS
+#define COUNT_IC(counter) ((counter)++)
+#else
+#define COUNT_IC(counter) ((void)0)
+#endif
+
+static Value clockNative(int, Value*)
+{
+    return Value::number(static_cast<double>(std::clock()) / CLOCKS_PER_SEC);
+}
+
+VM::VM(ErrorReporter& reporter, std::ostream& output): reporter(reporter), output(output), stack(INITIAL_STACK), stackLimit(stack.data() + stack.size()), frames(new CallFrame[FRAMES_MAX])
+{
+    resetStack();
+    heap.setRoots(this);
+
+    Heap::CollectionPause pause(heap);
+    initString = heap.makeString("init");
+    defineNative("clock", clockNative, 0);
+}
+
+LoxFunction* VM::compile(NodeList<Stmt*> statements)
+{
+    Heap::CollectionPause pause(heap);
+    Compiler compiler(heap, globals, reporter);
+    return compiler.compile(statements);
+}
+
+LoxFunction* VM::load(const BytecodeCache& cache, std::string_view script, std::string_view source)
+{
+    Heap::CollectionPause pause(heap);
+    return cache.load(script, source, heap, globals);
+}
+
+InterpretResult VM::interpret(LoxFunction* script)
+{
+    if (script == nullptr) return InterpretResult::COMPILE_ERROR;
+
+    // the script is pushed first so it's a root while its closure is allocated
+    push(Value::object(script));
+    LoxClosure* closure = newClosure(script);
+    stackTop[-1] = Value::object(closure);
+    call(closure, 0);
+    return run();
+}
+
+InterpretResult VM::run()
+{
+    CallFrame* frame = &frames[frameCount - 1];
+    // kept in a local so it can live in a register, written back to the frame before
+    // anything that needs it there (calls and errors)
+    const std::uint8_t* ip = frame->ip;
+
+    #define READ_BYTE() (*ip++)
+    #define READ_SHORT() (ip += 2, static_cast<std::uint16_t>((ip[-2] << 8) | ip[-1]))
+    #define READ_CONSTANT() (frame->function->chunk.constants[READ_SHORT()])
+    #define READ_STRING() (READ_CONSTANT().asObject<LoxString>())
+    #define READ_CACHE() (frame->function->chunk.caches[READ_SHORT()])
+    #define SAVE_IP() (frame->ip = ip)
+    #define LOAD_FRAME() (frame = &frames[frameCount - 1], ip = frame->ip)
+    #define RUNTIME_ERROR(...) do { SAVE_IP(); runtimeError(__VA_ARGS__); return InterpretResult::RUNTIME_ERROR; } while (false)
+    #define BINARY_OP(makeValue, op) \
+        do { \
+            if (!peek(0).isNumber() || !peek(1).isNumber()) RUNTIME_ERROR("Operands must be numbers."); \
+            double b = pop().asNumber(); \
+            double a = pop().asNumber(); \
+            push(Value::makeValue(a op b)); \
+        } while (false)
+
+    #ifdef LOX_DISPATCH_STATS
+    #define COUNT_DISPATCH() dispatchCounts.record(static_cast<OpCode>(*ip))
+    #else
+    #define COUNT_DISPATCH() ((void)0)
+    #endif
+
+    #ifdef LOX_COMPUTED_GOTO
+    // one indirect jump per instruction, at the end of each handler, which branch
+    // predicts far better than every instruction going back through one switch
+    static void* dispatchTable[] = {
+        #define LOX_OPCODE_LABEL(name, operands) &&op_##name,
+        LOX_OPCODES(LOX_OPCODE_LABEL)
+        #undef LOX_OPCODE_LABEL
+    };
+    #define CASE(name) op_##name
+    #define DISPATCH() do { COUNT_DISPATCH(); goto *dispatchTable[READ_BYTE()]; } while (false)
+
+    DISPATCH();
+    #else
+    #define CASE(name) case OpCode::name
+    #define DISPATCH() continue
+
+    for (;;)
+    {
+    COUNT_DISPATCH();
+    switch (static_cast<OpCode>(READ_BYTE()))
+    {
+    #endif
+
+        CASE(CONSTANT):
+            push(READ_CONSTANT());
+            DISPATCH();
+        CASE(NIL):
+            push(Value::nil());
+            DISPATCH();
+        CASE(TRUE):
+            push(Value::boolean(true));
+            DISPATCH();
+        CASE(FALSE):
+            push(Value::boolean(false));
+            DISPATCH();
+        CASE(POP):
+            pop();
+            DISPATCH();
+        CASE(GET_LOCAL):
+            push(frame->slots[READ_BYTE()]);
+            DISPATCH();
+        CASE(SET_LOCAL):
+            // assignment is an expression, the value stays on the stack
+            frame->slots[READ_BYTE()] = peek(0);
+            DISPATCH();
+        CASE(GET_GLOBAL):
+        {
+            int slot = READ_SHORT();
+            if (!globals.isDefined(slot)) RUNTIME_ERROR("Undefined variable '%s'.", globals.name(slot)->toString().c_str());
+            push(globals.value(slot));
+            DISPATCH();
+        }
+        CASE(DEFINE_GLOBAL):
+        {
+            int slot = READ_SHORT();
+            heap.writeBarrier(nullptr, globals.value(slot), peek(0));
+            globals.define(slot, pop());
+            DISPATCH();
+        }
+        CASE(SET_GLOBAL):
+        {
+            int slot = READ_SHORT();
+            if (!globals.isDefined(slot)) RUNTIME_ERROR("Undefined variable '%s'.", globals.name(slot)->toString().c_str());
+            heap.writeBarrier(nullptr, globals.value(slot), peek(0));
+            globals.value(slot) = peek(0);
+            DISPATCH();
+        }
+        CASE(GET_UPVALUE):
+            push(frame->closure->upvalue(READ_BYTE())->value());
+            DISPATCH();
+        CASE(SET_UPVALUE):
+        {
+            LoxUpvalue* upvalue = frame->closure->upvalue(READ_BYTE());
+            // an open upvalue's variable is on the stack, which needs no barrier
+            if (!upvalue->isOpen()) heap.writeBarrier(upvalue, upvalue->closed, peek(0));
+            upvalue->value() = peek(0);
+            DISPATCH();
+        }
+        CASE(GET_PROPERTY):
+        getProperty:
+        {
+            if (!peek(0).isObjectType(ObjectType::INSTANCE)) RUNTIME_ERROR("Only instances have properties.");
+
+            LoxInstance* instance = peek(0).asObject<LoxInstance>();
+            LoxString* name = READ_STRING();
+            Property property = findProperty(instance, name, READ_CACHE(), icCounts.get);
+
+            if (property.field)
+            {
+                Value value = *property.field;
+                pop();
+                push(value);
+                DISPATCH();
+            }
+            if (property.method == nullptr) RUNTIME_ERROR("Undefined property '%s'.", name->toString().c_str());
+
+            SAVE_IP();
+            bindMethod(property.method);
+            DISPATCH();
+        }
+        CASE(SET_PROPERTY):
+        {
+            if (!peek(1).isObjectType(ObjectType::INSTANCE)) RUNTIME_ERROR("Only instances have fields.");
+
+            LoxString* name = READ_STRING();
+            setField(name, READ_CACHE());
+
+            Value value = pop();
+            pop();
+            push(value);
+            DISPATCH();
+        }
+        CASE(GET_SUPER):
+        {
+            LoxString* name = READ_STRING();
+            LoxClass* superclass = pop().asObject<LoxClass>();
+
+            SAVE_IP();
+            if (!bindMethod(superclass, name)) return InterpretResult::RUNTIME_ERROR;
+            DISPATCH();
+        }
+        CASE(EQUAL):
+        {
+            Value b = pop();
+            Value a = pop();
+            push(Value::boolean(a == b));
+            DISPATCH();
+        }
+        CASE(GREATER):
+            BINARY_OP(boolean, >);
+            DISPATCH();
+        CASE(LESS):
+            BINARY_OP(boolean, <);
+            DISPATCH();
+        CASE(ADD):
+        add:
+        {
+            if (peek(0).isNumber() && peek(1).isNumber())
+            {
+                double b = pop().asNumber();
+                double a = pop().asNumber();
+                push(Value::number(a + b));
+            }
+            else if (peek(0).isObjectType(ObjectType::STRING) && peek(1).isObjectType(ObjectType::STRING))
+            {
+                std::size_t length = peek(0).asObject<LoxString>()->length + peek(1).asObject<LoxString>()->length;
+                LoxString* result = heap.allocateString(length);
+                // allocating may have moved the operands
+                std::string_view b = peek(0).asObject<LoxString>()->view();
+                std::string_view a = peek(1).asObject<LoxString>()->view();
+                a.copy(result->chars(), a.size());
+                b.copy(result->chars() + a.size(), b.size());
+
+                result = heap.intern(result);
+                pop();
+                pop();
+                push(Value::object(result));
+            }
+            else
+            {
+                RUNTIME_ERROR("Operands must be two numbers or two strings.");
+            }
+            DISPATCH();
+        }
+        CASE(SUBTRACT):
+            BINARY_OP(number, -);
+            DISPATCH();
+        CASE(MULTIPLY):
+            BINARY_OP(number, *);
+            DISPATCH();
+        CASE(DIVIDE):
+            BINARY_OP(number, /);
+            DISPATCH();
+        CASE(NOT):
+            push(Value::boolean(pop().isFalsey()));
+            DISPATCH();
+        CASE(NEGATE):
+            if (!peek(0).isNumber()) RUNTIME_ERROR("Operand must be a number.");
+            push(Value::number(-pop().asNumber()));
+            DISPATCH();
+        CASE(PRINT):
+            output << pop().toString() << '\n';
+            DISPATCH();
+        CASE(JUMP):
+        {
+            std::uint16_t offset = READ_SHORT();
+            ip += offset;
+            DISPATCH();
+        }
+        CASE(JUMP_IF_FALSE):
+        {
+            std::uint16_t offset = READ_SHORT();
+            if (peek(0).isFalsey()) ip += offset;
+            DISPATCH();
+        }
+        CASE(LOOP):
+        {
+            std::uint16_t offset = READ_SHORT();
+            ip -= offset;
+            DISPATCH();
+        }
+        CASE(CALL):
+        CASE(TAIL_CALL):
+        {
+            // one handler for both keeps the dispatch loop small, a tail call to a native or a
+            // class without init doesn't take the frame over, the RETURN after it returns the result
+            bool tail = static_cast<OpCode>(ip[-1]) == OpCode::TAIL_CALL;
+            int argCount = READ_BYTE();
+            SAVE_IP();
+            // plain calls to closures are most calls, they skip callValue's switch
+            Value callee = peek(argCount);
+            bool called = callee.isObjectType(ObjectType::CLOSURE) && !tail
+                ? call(callee.asObject<LoxClosure>(), argCount)
+                : callValue(callee, argCount, tail);
+            if (!called) return InterpretResult::RUNTIME_ERROR;
+            LOAD_FRAME();
+            DISPATCH();
+        }
+        CASE(INVOKE):
+        CASE(TAIL_INVOKE):
+        {
+            bool tail = static_cast<OpCode>(ip[-1]) == OpCode::TAIL_INVOKE;
+            LoxString* method = READ_STRING();
+            int argCount = READ_BYTE();
+            InlineCache& cache = READ_CACHE();
+            SAVE_IP();
+            if (!invoke(method, argCount, cache, tail)) return InterpretResult::RUNTIME_ERROR;
+            LOAD_FRAME();
+            DISPATCH();
+        }
+        CASE(SUPER_INVOKE):
+        {
+            LoxString* method = READ_STRING();
+            int argCount = READ_BYTE();
+            LoxClass* superclass = pop().asObject<LoxClass>();
+            SAVE_IP();
+            if (!invokeFromClass(superclass, method, argCount)) return InterpretResult::RUNTIME_ERROR;
+            LOAD_FRAME();
+            DISPATCH();
+        }
+        CASE(CLOSURE):
+        {
+            LoxFunction* function = READ_CONSTANT().asObject<LoxFunction>();
+            push(Value::object(newClosure(function)));
+            for (int i = 0; i < function->upvalueCount; i++)
+            {
+                bool isLocal = READ_BYTE();
+                int index = READ_BYTE();
+                LoxUpvalue* upvalue = isLocal ? captureUpvalue(frame->slots + index) : frame->closure->upvalue(index);
+                // capturing allocates, which can move the closure
+                LoxClosure* closure = peek(0).asObject<LoxClosure>();
+                heap.writeBarrier(closure, Value::nil(), Value::object(upvalue));
+                closure->upvalue(i) = upvalue;
+            }
+            DISPATCH();
+        }
+        CASE(CLOSE_UPVALUE):
+            closeUpvalues(stackTop - 1);
+            pop();
+            DISPATCH();
+        CASE(RETURN):
+        {
+            Value result = pop();
+            if (openUpvalues) closeUpvalues(frame->slots);
+            frameCount--;
+            if (frameCount == 0)
+            {
+                // the script function itself
+                pop();
+                return InterpretResult::OK;
+            }
+
+            // drop the callee, its arguments and locals in one go
+            stackTop = frame->slots;
+            push(result);
+            LOAD_FRAME();
+            DISPATCH();
+        }
+        CASE(CLASS):
+        {
+            push(Value::object(heap.allocate<LoxClass>(READ_STRING())));
+            // classes are never moved, only young objects are
+            LoxClass* klass = peek(0).asObject<LoxClass>();
+            klass->rootShape = heap.allocate<Shape>(klass);
+            DISPATCH();
+        }
+        CASE(INHERIT):
+        {
+            if (!peek(1).isObjectType(ObjectType::CLASS)) RUNTIME_ERROR("Superclass must be a class.");
+
+            // methods are copied down before the subclass's own are added, so overrides win
+            LoxClass* superclass = peek(1).asObject<LoxClass>();
+            LoxClass* subclass = peek(0).asObject<LoxClass>();
+            subclass->methods.addAll(superclass->methods);
+            heap.remember(subclass);
+            pop();
+            DISPATCH();
+        }
+        CASE(METHOD):
+        {
+            LoxString* name = READ_STRING();
+            LoxClass* klass = peek(1).asObject<LoxClass>();
+            // overriding an inherited method replaces it
+            setEntry(klass, klass->methods, name, peek(0));
+            pop();
+            DISPATCH();
+        }
+        CASE(GET_LOCAL_CONSTANT):
+            push(frame->slots[READ_BYTE()]);
+            push(READ_CONSTANT());
+            DISPATCH();
+        CASE(ADD_LOCAL_CONSTANT):
+        {
+            Value a = frame->slots[READ_BYTE()];
+            Value b = READ_CONSTANT();
+            if (a.isNumber() && b.isNumber())
+            {
+                push(Value::number(a.asNumber() + b.asNumber()));
+                DISPATCH();
+            }
+            // strings and errors are left to ADD
+            push(a);
+            push(b);
+            goto add;
+        }
+        CASE(SUBTRACT_LOCAL_CONSTANT):
+            push(frame->slots[READ_BYTE()]);
+            push(READ_CONSTANT());
+            BINARY_OP(number, -);
+            DISPATCH();
+        CASE(GET_LOCAL_PROPERTY):
+            push(frame->slots[READ_BYTE()]);
+            goto getProperty;
+        CASE(SET_LOCAL_POP):
+            frame->slots[READ_BYTE()] = pop();
+            DISPATCH();
+        CASE(JUMP_IF_FALSE_POP):
+        {
+            std::uint16_t offset = READ_SHORT();
+            if (pop().isFalsey()) ip += offset;
+            DISPATCH();
+        }
+        CASE(LESS_JUMP_IF_FALSE):
+        {
+            std::uint16_t offset = READ_SHORT();
+            if (!peek(0).isNumber() || !peek(1).isNumber()) RUNTIME_ERROR("Operands must be numbers.");
+            double b = pop().asNumber();
+            double a = pop().asNumber();
+            if (!(a < b)) ip += offset;
+            DISPATCH();
+        }
+
+    #ifndef LOX_COMPUTED_GOTO
+    }
+    }
+    #endif
+
+    #undef READ_BYTE
+    #undef READ_SHORT
+    #undef READ_CONSTANT
+    #undef READ_STRING
+    #undef SAVE_IP
+    #undef LOAD_FRAME
+    #undef RUNTIME_ERROR
+    #undef BINARY_OP
+    #undef COUNT_DISPATCH
+    #undef CASE
+    #undef DISPATCH
+}
+
+bool VM::callValue(Value callee, int argCount, bool tail)
+{
+    if (callee.isObject())
+    {
+        switch (callee.asObject()->type)
+        {
+            case ObjectType::CLOSURE:
+                return tail ? tailCall(callee.asObject<LoxClosure>(), argCount) : call(callee.asObject<LoxClosure>(), argCount);
+            case ObjectType::BOUND_METHOD:
+            {
+                // the receiver takes the callee's slot, so it's slot 0 ('this') in the method
+                LoxBoundMethod* bound = callee.asObject<LoxBoundMethod>();
+                stackTop[-argCount - 1] = bound->receiver;
+                return tail ? tailCall(bound->method, argCount) : call(bound->method, argCount);
+            }
+            case ObjectType::CLASS:
+            {
+                LoxClass* klass = callee.asObject<LoxClass>();
+                std::uint32_t capacity = klass->instanceFields;
+                LoxInstance* instance = heap.allocateSized<LoxInstance>(LoxInstance::allocationSize(capacity), klass->rootShape, capacity);
+                stackTop[-argCount - 1] = Value::object(instance);
+
+                if (Value* initializer = klass->methods.find(initString))
+                {
+                    LoxClosure* init = initializer->asObject<LoxClosure>();
+                    return tail ? tailCall(init, argCount) : call(init, argCount);
+                }
+                if (argCount != 0)
+                {
+                    runtimeError("Expected 0 arguments but got %d.", argCount);
+                    return false;
+                }
+                return true;
+            }
+            case ObjectType::NATIVE:
+            {
+                LoxNative* native = callee.asObject<LoxNative>();
+                if (argCount != native->arity)
+                {
+                    runtimeError("Expected %d arguments but got %d.", native->arity, argCount);
+                    return false;
+                }
+
+                Value result = native->function(argCount, stackTop - argCount);
+                stackTop -= argCount + 1;
+                push(result);
+                return true;
+            }
+            default:
+                break;
+        }
+    }
+
+    runtimeError("Can only call functions and classes.");
+    return false;
+}
+
+bool VM::call(LoxClosure* closure, int argCount)
+{
+    LoxFunction* function = closure->function;
+    if (argCount != function->arity)
+    {
+        runtimeError("Expected %d arguments but got %d.", function->arity, argCount);
+        return false;
+    }
+
+    if (frameCount == FRAMES_MAX)
+    {
+        runtimeError("Stack overflow.");
+        return false;
+    }
+
+    Value* slots = stackTop - argCount - 1;
+    if (slots + function->maxSlots > stackLimit)
+    {
+        growStack(slots + function->maxSlots);
+        slots = stackTop - argCount - 1;
+    }
+
+    CallFrame& frame = frames[frameCount++];
+    frame.closure = closure;
+    frame.function = function;
+    frame.ip = function->chunk.code.data();
+    frame.slots = slots;
+    return true;
+}
+
+// the caller is done with its frame, so the callee and its arguments move down and take it over
+bool VM::tailCall(LoxClosure* closure, int argCount)
+{
+    LoxFunction* function = closure->function;
+    if (argCount != function->arity)
+    {
+        runtimeError("Expected %d arguments but got %d.", function->arity, argCount);
+        return false;
+    }
+
+    CallFrame& frame = frames[frameCount - 1];
+    if (openUpvalues) closeUpvalues(frame.slots);
+    stackTop = std::copy(stackTop - argCount - 1, stackTop, frame.slots);
+    if (frame.slots + function->maxSlots > stackLimit) growStack(frame.slots + function->maxSlots);
+
+    frame.closure = closure;
+    frame.function = function;
+    frame.ip = function->chunk.code.data();
+    return true;
+}
+
+bool VM::invoke(LoxString* name, int argCount, InlineCache& cache, bool tail)
+{
+    Value receiver = peek(argCount);
+    if (!receiver.isObjectType(ObjectType::INSTANCE))
+    {
+        runtimeError("Only instances have methods.");
+        return false;
+    }
+
+    Property property = findProperty(receiver.asObject<LoxInstance>(), name, cache, icCounts.invoke);
+
+    // a field holding something callable, call it like any other value
+    if (property.field)
+    {
+        Value callee = *property.field;
+        stackTop[-argCount - 1] = callee;
+        return callValue(callee, argCount, tail);
+    }
+    if (property.method == nullptr)
+    {
+        runtimeError("Undefined property '%s'.", name->toString().c_str());
+        return false;
+    }
+
+    return tail ? tailCall(property.method, argCount) : call(property.method, argCount);
+}
+
+// a field of instance called name or else its class's method, through the site's cache
+// - counts is only added to when built with LOX_IC_STATS
+VM::Property VM::findProperty(LoxInstance* instance, LoxString* name, InlineCache& cache, [[maybe_unused]] IcStats::Counts& counts)
+{
+    Shape* shape = instance->shape;
+    if (cache.isMegamorphic())
+    {
+        COUNT_IC(counts.megamorphic);
+    }
+    else if (InlineCache::Entry* entry = cache.lookup(shape))
+    {
+        COUNT_IC(counts.hits);
+        if (entry->method) return Property{nullptr, entry->method};
+        return Property{&instance->field(entry->slot), nullptr};
+    }
+    else
+    {
+        COUNT_IC(counts.misses);
+    }
+
+    // fields shadow methods
+    int slot = shape->find(name);
+    if (slot >= 0)
+    {
+        cache.remember(InlineCache::Entry{shape, nullptr, nullptr, slot});
+        return Property{&instance->field(slot), nullptr};
+    }
+
+    Value* method = shape->klass->methods.find(name);
+    if (method == nullptr) return Property{nullptr, nullptr};
+
+    LoxClosure* closure = method->asObject<LoxClosure>();
+    cache.remember(InlineCache::Entry{shape, closure, nullptr, -1});
+    return Property{nullptr, closure};
+}
+
+// [instance, value] on the stack, stays that way
+void VM::setField(LoxString* name, InlineCache& cache)
+{
+    LoxInstance* instance = peek(1).asObject<LoxInstance>();
+    Shape* shape = instance->shape;
+    InlineCache::Entry found;
+    InlineCache::Entry* entry = nullptr;
+    if (cache.isMegamorphic())
+    {
+        COUNT_IC(icCounts.set.megamorphic);
+    }
+    else if ((entry = cache.lookup(shape)))
+    {
+        COUNT_IC(icCounts.set.hits);
+    }
+    else
+    {
+        COUNT_IC(icCounts.set.misses);
+    }
+
+    if (entry == nullptr)
+    {
+        found = InlineCache::Entry{shape, nullptr, nullptr, shape->find(name)};
+        if (found.slot < 0)
+        {
+            found.slot = static_cast<int>(shape->slotCount);
+            found.next = shape->transition(name);
+            if (found.next == nullptr)
+            {
+                found.next = newShape(shape, name);
+                instance = peek(1).asObject<LoxInstance>();
+            }
+        }
+        cache.remember(found);
+        entry = &found;
+    }
+
+    Value value = peek(0);
+    if (entry->next)
+    {
+        // the old shape is the new one's parent, so it doesn't need the barrier
+        heap.writeBarrier(instance, Value::nil(), value);
+        instance->addField(entry->next, value);
+    }
+    else
+    {
+        Value& field = instance->field(entry->slot);
+        heap.writeBarrier(instance, field, value);
+        field = value;
+    }
+}
+
+// the child of parent for adding name, the first instance to take that path is here
+Shape* VM::newShape(Shape* parent, LoxString* name)
+{
+    // shapes are old, so allocating one can move name but not parent
+    Shape* child = heap.allocate<Shape>(parent, name);
+    heap.writeBarrier(child, Value::nil(), Value::object(child->name));
+    heap.writeBarrier(parent, Value::nil(), Value::object(child->name));
+    parent->addTransition(child);
+
+    LoxClass* klass = parent->klass;
+    if (child->slotCount > klass->instanceFields && child->slotCount <= MAX_INLINE_FIELDS)
+    {
+        klass->instanceFields = child->slotCount;
+    }
+    return child;
+}
+
+bool VM::invokeFromClass(LoxClass* klass, LoxString* name, int argCount)
+{
+    Value* method = klass->methods.find(name);
+    if (method == nullptr)
+    {
+        runtimeError("Undefined property '%s'.", name->toString().c_str());
+        return false;
+    }
+
+    return call(method->asObject<LoxClosure>(), argCount);
+}
+
+// replaces the instance on top of the stack with its method name bound to it
+bool VM::bindMethod(LoxClass* klass, LoxString* name)
+{
+    Value* method = klass->methods.find(name);
+    if (method == nullptr)
+    {
+        runtimeError("Undefined property '%s'.", name->toString().c_str());
+        return false;
+    }
+
+    bindMethod(method->asObject<LoxClosure>());
+    return true;
+}
+
+// same, for a method that's already been looked up
+void VM::bindMethod(LoxClosure* method)
+{
+    // the receiver is set afterwards, allocating may move it
+    LoxBoundMethod* bound = heap.allocate<LoxBoundMethod>(Value::nil(), method);
+    bound->receiver = peek(0);
+    heap.writeBarrier(bound, Value::nil(), bound->receiver);
+    pop();
+    push(Value::object(bound));
+}
+
+LoxClosure* VM::newClosure(LoxFunction* function)
+{
+    std::size_t size = LoxClosure::allocationSize(function);
+    if (!function->isMethod) return heap.allocateSized<LoxClosure>(size, function);
+
+    // caches and bound methods point at methods without a barrier, so they must never move
+    Heap::CollectionPause pause(heap);
+    return heap.allocateSized<LoxClosure>(size, function);
+}
+
+// the open upvalue for slot, there's only ever one so closures capturing the same variable share it
+LoxUpvalue* VM::captureUpvalue(Value* slot)
+{
+    for (LoxUpvalue* upvalue = openUpvalues; upvalue && upvalue->slot >= slot; upvalue = upvalue->nextOpen)
+    {
+        if (upvalue->slot == slot) return upvalue;
+    }
+
+    // the list is walked again for the insertion point, allocating can move the upvalues in it
+    LoxUpvalue* created = heap.allocate<LoxUpvalue>(slot);
+    LoxUpvalue* previous = nullptr;
+    LoxUpvalue* next = openUpvalues;
+    while (next && next->slot > slot)
+    {
+        previous = next;
+        next = next->nextOpen;
+    }
+
+    if (next) heap.writeBarrier(created, Value::nil(), Value::object(next));
+    created->nextOpen = next;
+    if (previous)
+    {
+        heap.writeBarrier(previous, Value::nil(), Value::object(created));
+        previous->nextOpen = created;
+    }
+    else
+    {
+        openUpvalues = created;
+    }
+    return created;
+}
+
+// closes every open upvalue for last and the slots above it, moving their variables off the stack
+void VM::closeUpvalues(Value* last)
+{
+    while (openUpvalues && openUpvalues->slot >= last)
+    {
+        LoxUpvalue* upvalue = openUpvalues;
+        heap.writeBarrier(upvalue, Value::nil(), *upvalue->slot);
+        upvalue->closed = *upvalue->slot;
+        upvalue->slot = nullptr;
+        openUpvalues = upvalue->nextOpen;
+        upvalue->nextOpen = nullptr;
+    }
+}
+
+// at least doubles the stack so it reaches end, everything pointing into it moves along with it
+void VM::growStack(Value* end)
+{
+    std::vector<Value> grown(std::max(static_cast<std::size_t>(end - stack.data()), stack.size() * 2));
+    Value* base = grown.data();
+    auto rebase = [&](Value* slot) { return base + (slot - stack.data()); };
+
+    std::copy(stack.data(), stackTop, base);
+    for (int i = 0; i < frameCount; i++) frames[i].slots = rebase(frames[i].slots);
+    for (LoxUpvalue* upvalue = openUpvalues; upvalue; upvalue = upvalue->nextOpen) upvalue->slot = rebase(upvalue->slot);
+    stackTop = rebase(stackTop);
+    stack.swap(grown);
+    stackLimit = stack.data() + stack.size();
+}
+
+void VM::defineNative(std::string_view name, NativeFn function, int arity)
+{
+    globals.define(globals.resolve(heap.makeString(name)), Value::object(heap.allocate<LoxNative>(function, arity)));
+}
+
+// Table::set for a table owner holds, the references it gains and loses go through the write barrier
+void VM::setEntry(Object* owner, Table& table, LoxString* key, Value value)
+{
+    if (Value* slot = table.find(key))
+    {
+        heap.writeBarrier(owner, *slot, value);
+        *slot = value;
+    }
+    else
+    {
+        heap.writeBarrier(owner, Value::nil(), Value::object(key));
+        heap.writeBarrier(owner, Value::nil(), value);
+        table.set(key, value);
+    }
+}
+
+void VM::traceRoots(Tracer& tracer)
+{
+    for (Value* slot = stack.data(); slot < stackTop; slot++) tracer.visit(*slot);
+    // a bound method's receiver takes over the callee's slot, so frames hold the only reference to some closures
+    for (int i = 0; i < frameCount; i++)
+    {
+        tracer.visit(frames[i].closure);
+        tracer.visit(frames[i].function);
+    }
+    tracer.visit(openUpvalues);
+    globals.trace(tracer);
+    tracer.visit(initString);
+}
+
+void VM::runtimeError(const char* format, ...)
+{
+    // formatted in full first so the reporter writes it out in one piece, names
+    // in the message can be any length so it's measured before it's written
+    std::va_list args, measuring;
+    va_start(args, format);
+    va_copy(measuring, args);
+    std::string report(std::vsnprintf(nullptr, 0, format, measuring), '\0');
+    va_end(measuring);
+    std::vsnprintf(report.data(), report.size() + 1, format, args);
+    va_end(args);
+    report += '\n';
+
+    // innermost call first, ip has already moved past the failing instruction
+    for (int i = frameCount - 1; i >= 0; i--)
+    {
+        // skipping a single frame would take as much room as showing it
+        if (i == frameCount - 1 - TRACE_FRAMES && i > TRACE_FRAMES)
+        {
+            report += "... " + std::to_string(i - TRACE_FRAMES + 1) + " more frames\n";
+            i = TRACE_FRAMES;
+            continue;
+        }
+
+        const CallFrame& frame = frames[i];
+        const Chunk& chunk = frame.function->chunk;
+        int line = chunk.getLine(static_cast<int>(frame.ip - chunk.code.data()) - 1);
+
+        report += "[Line " + std::to_string(line) + "] in ";
+        report += frame.function->name == nullptr ? "script" : frame.function->name->toString() + "()";
+        report += '\n';
+    }
+
+    reporter.runtimeError(report);
+    resetStack();
+}
+
+void VM::resetStack()
+{
+    stackTop = stack.data();
+    frameCount = 0;
+    openUpvalues = nullptr;
+}
@@ -0,0 +1,134 @@
+#ifndef VM_H
+#define VM_H
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "bytecode_cache.h"
+#include "dispatch_stats.h"
+#include "globals.h"
+#include "heap.h"
+#include "inline_cache.h"
+#include "table.h"
+#include "lox/error_reporter.h"
+#include "lox/parser/ast.h"
+#include "lox/types/value.h"
+#include "lox/types/lox_function.h"
+#include "lox/types/lox_closure.h"
+#include "lox/types/lox_upvalue.h"
+#include "lox/types/lox_class.h"
+#include "lox/types/lox_instance.h"
+#include "lox/types/shape.h"
+#include "lox/types/lox_native.h"
+
+enum class InterpretResult { OK, COMPILE_ERROR, RUNTIME_ERROR };
+
+// Stack based bytecode interpreter. One VM keeps its globals and heap
+// between scripts, so the REPL can build on earlier lines.
+// - each call pushes a CallFrame whose slots start at the callee on the stack,
+//   a tail call (return f(...)) moves the callee down and reuses the caller's
+// - calls go up to FRAMES_MAX deep, the stack grows as they need it and the
+//   frames are only touched as deep as they go
+// - captured locals stay in their stack slots while their function runs,
+//   the open upvalues pointing at them are closed when the slots go
+// - the dispatch loop uses computed gotos where the compiler supports them,
+//   define LOX_NO_COMPUTED_GOTO to build the plain switch instead, and
+//   LOX_DISPATCH_STATS to count every instruction dispatched (LOX_IC_STATS
+//   counts inline cache hits the same way)
+// - runtime errors report a message and stack trace to the ErrorReporter
+//   (the TRACE_FRAMES innermost and outermost calls of a deep one),
+//   then unwind everything
+// - the stack, call frames and globals are the collector's roots
+class VM: private RootSource
+{
+    public:
+        // compile and runtime errors go to reporter and print to output, both must outlive the VM
+        explicit VM(ErrorReporter& reporter, std::ostream& output = std::cout);
+
+        VM(const VM&) = delete;
+        VM& operator=(const VM&) = delete;
+
+        // nullptr if there were compile errors, collection is paused while compiling
+        LoxFunction* compile(NodeList<Stmt*> statements);
+        // script's entry in cache if it was compiled from source, nullptr if there's none this VM can run
+        LoxFunction* load(const BytecodeCache& cache, std::string_view script, std::string_view source);
+        InterpretResult interpret(LoxFunction* script);
+
+        // for the scanner to intern identifiers into as it goes
+        Heap& getHeap() { return heap; }
+        // for the disassembler to name global slots
+        const Globals& getGlobals() const { return globals; }
+        // all zeros unless built with LOX_IC_STATS
+        const IcStats& icStats() const { return icCounts; }
+        // all zeros unless built with LOX_DISPATCH_STATS
+        const DispatchStats& dispatchStats() const { return dispatchCounts; }
+
+    private:
+        // deeper than this is a stack overflow, not a program that needs the memory
+        static constexpr int FRAMES_MAX = 100000;
+        // calls grow the stack as they need it, starting small keeps page faults out of startup
+        static constexpr int INITIAL_STACK = 256;
+        // a runtime error's trace shows this many frames at each end, a deep recursion's middle is one line
+        static constexpr int TRACE_FRAMES = 10;
+        // instances with more fields than this keep the rest out of line
+        static constexpr std::uint32_t MAX_INLINE_FIELDS = 32;
+
+        struct CallFrame
+        {
+            LoxClosure* closure;
+            LoxFunction* function; // the closure's, saves an indirection on every constant read
+            const std::uint8_t* ip;
+            Value* slots;
+        };
+
+        // what a property name found on an instance, both nullptr if it's undefined
+        struct Property
+        {
+            Value* field;
+            LoxClosure* method;
+        };
+
+        InterpretResult run();
+
+        void push(Value value) { *stackTop++ = value; }
+        Value pop() { return *--stackTop; }
+        Value peek(int distance) const { return stackTop[-1 - distance]; }
+
+        // tail calls replace the current frame instead of pushing one
+        bool callValue(Value callee, int argCount, bool tail);
+        bool call(LoxClosure* closure, int argCount);
+        bool tailCall(LoxClosure* closure, int argCount);
+        bool invoke(LoxString* name, int argCount, InlineCache& cache, bool tail);
+        Property findProperty(LoxInstance* instance, LoxString* name, InlineCache& cache, IcStats::Counts& counts);
+        void setField(LoxString* name, InlineCache& cache);
+        Shape* newShape(Shape* parent, LoxString* name);
+        bool invokeFromClass(LoxClass* klass, LoxString* name, int argCount);
+        bool bindMethod(LoxClass* klass, LoxString* name);
+        void bindMethod(LoxClosure* method);
+        LoxClosure* newClosure(LoxFunction* function);
+        LoxUpvalue* captureUpvalue(Value* slot);
+        void closeUpvalues(Value* last);
+        void growStack(Value* end);
+        void defineNative(std::string_view name, NativeFn function, int arity);
+        void setEntry(Object* owner, Table& table, LoxString* key, Value value);
+        virtual void traceRoots(Tracer& tracer) override;
+
+        void runtimeError(const char* format, ...);
+        void resetStack();
+
+        ErrorReporter& reporter;
+        std::ostream& output;
+        Heap heap;
+        std::vector<Value> stack;
+        Value* stackTop;
+        Value* stackLimit; // the end of stack, calls grow it when their slots would go past
+        std::unique_ptr<CallFrame[]> frames; // left uninitialized, so untouched pages cost nothing
+        int frameCount = 0;
+        LoxUpvalue* openUpvalues = nullptr;
+        Globals globals;
+        LoxString* initString;
+        IcStats icCounts;
+        DispatchStats dispatchCounts;
+};
+#endif
@@ -4,8 +4,8 @@
 // handle UTF-8 encoding for Windows and Linux
 #ifdef _WIN32
 #include <windows.h>
-#elif defined(__LINUX__) || defined(__UNIX__) || defined(__APPLE__)
-#include <cstdlib>
+#else
+#include <clocale>
 #endif
 
 // argc is the arg count
@@ -15,12 +15,15 @@ int main(int argc, char*argv[])
     #ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
-    #elif defined(__LINUX__) || defined(__UNIX__) || defined(__APPLE__)
-    std::system("export LANG=en_US.UTF-8");
+    #else
+    // Lox strings are bytes and UTF-8 passes through them untouched, only the C library's
+    // character handling looks at the locale, so LC_CTYPE is taken from the environment
+    // in process (exporting LANG from a child shell never reached this process anyway)
+    std::setlocale(LC_CTYPE, "");
     #endif
 
     Lox lox;
     lox.run(argc, argv);
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}